@@ -0,0 +1,73 @@
+// ============================================================================
+// encode_bench.cpp - encoder throughput in MB of code per second
+//
+//   bin/encode_bench [instructions] [repeats]
+//
+// Parses a generated program once, then encodes it `repeats` times and
+// reports the best run, plus the heap allocations one encode performs.
+// ============================================================================
+#include "assembler/Encoder.hpp"
+#include "assembler/Parser.hpp"
+#include "assembler/Stats.hpp"
+#include "assembler/Tokenizer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static std::string generate(size_t instructions) {
+    std::string s;
+    size_t n = 0;
+    for (unsigned block = 0; n < instructions; ++block) {
+        s += "L" + std::to_string(block) + ":\n";
+        s += "    LOAD 0\n";
+        s += "    PUSH " + std::to_string(block % 1000) + "\n";
+        s += "    IADD\n";
+        s += "    DUP\n";
+        s += "    STORE 0\n";
+        s += "    JNZ L" + std::to_string(block) + "\n";
+        n += 6;
+    }
+    return s;
+}
+
+int main(int argc, char** argv) {
+    size_t count   = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+    int    repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+    std::string src = generate(count);
+
+    assembler::Interner names;
+    Tokenizer tokenizer(src, &names);
+    Parser parser(tokenizer, names);
+    std::vector<Instruction> instrs = parser.parse();
+    const SymbolTable& symtab = parser.symbols();
+
+    double best = 1e30;
+    size_t bytes = 0;
+    for (int r = 0; r < repeats; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        assembler::Encoder::Report rep =
+            assembler::Encoder::encode(instrs, names, symtab.fixups(), symtab.lc());
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (!rep.errors.empty()) {
+            std::fprintf(stderr, "%s\n", rep.errors.front().c_str());
+            return 1;
+        }
+        bytes = rep.code.size();
+        if (s < best) best = s;
+    }
+
+    assembler::stats::enable();
+    {
+        assembler::stats::Phase phase("encode");
+        assembler::Encoder::encode(instrs, names, symtab.fixups(), symtab.lc());
+    }
+    const auto& p = assembler::stats::phases().back();
+
+    std::printf("instructions: %zu\n", instrs.size());
+    std::printf("code bytes:   %zu\n", bytes);
+    std::printf("encode:       %.1f ms, %.1f MB/s, %.1f M instr/s\n", best * 1e3,
+                bytes / best / 1e6, instrs.size() / best / 1e6);
+    std::printf("allocations:  %llu per encode\n", (unsigned long long)p.allocs);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// ============================================================================
+// input_bench.cpp - startup time and peak RSS of the input paths
+//
+//   bin/input_bench <file.asm> <legacy|mmap|stream>
+//
+// legacy: ifstream -> ostringstream -> std::string, plus the Tokenizer-side
+//         copy the old driver made (three copies of the input)
+// mmap:   SourceFile mapping, tokenized in place
+// stream: StreamBuffer chunked reads (the pipe/stdin path)
+//
+// Run each mode in its own process so peak RSS is per mode. Tokens are
+// counted, not stored, so only the input path shows up in RSS.
+// ============================================================================
+#include "assembler/Input.hpp"
+#include "assembler/Tokenizer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace assembler;
+using Clock = std::chrono::steady_clock;
+
+static long peak_rss_mb() {
+#ifndef _WIN32
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss >> 10;
+#else
+    return 0;
+#endif
+}
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Pulls the first token (startup) and then the rest.
+static void run(TokenSource& src, Clock::time_point t0, const char* mode) {
+    Token t = src.next();
+    double first = since(t0);
+    std::size_t n = 1;
+    while (t.type != TokenType::END_OF_FILE) {
+        t = src.next();
+        ++n;
+    }
+    std::printf("%-7s first token %8.3f ms   all %zu tokens %7.2f s   peak RSS %ld MB\n",
+                mode, first * 1e3, n, since(t0), peak_rss_mb());
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: input_bench <file.asm> <legacy|mmap|stream>\n");
+        return 1;
+    }
+    std::string path = argv[1], mode = argv[2];
+    auto t0 = Clock::now();
+
+    if (mode == "legacy") {
+        std::ifstream in(path);
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        std::string text = ss.str();
+        std::string copy = text;          // the Tokenizer's own copy
+        Tokenizer tok(copy);
+        run(tok, t0, "legacy");
+    } else if (mode == "mmap") {
+        SourceFile f = SourceFile::open(path);
+        if (!f.mapped()) { std::fprintf(stderr, "not mappable\n"); return 1; }
+        Tokenizer tok(f.text());
+        run(tok, t0, "mmap");
+    } else {
+        SourceFile f = SourceFile::open(path);
+        StreamBuffer buf(f.fd());
+        Tokenizer tok(buf);
+        run(tok, t0, "stream");
+    }
+    return 0;
+}
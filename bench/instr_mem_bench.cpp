@@ -0,0 +1,58 @@
+// ============================================================================
+// instr_mem_bench.cpp - heap bytes and allocations behind each Instruction
+//
+//   bin/instr_mem_bench [instructions]
+//
+// Parses a generated program, then deep-copies the instruction vector inside
+// a stats phase: the phase's allocation count and peak live heap are what
+// one copy of the parsed program costs.
+// ============================================================================
+#include "assembler/Parser.hpp"
+#include "assembler/Stats.hpp"
+#include "assembler/Tokenizer.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static std::string generate(size_t instructions) {
+    std::string s;
+    size_t n = 0;
+    for (unsigned block = 0; n < instructions; ++block) {
+        s += "L" + std::to_string(block) + ":\n";
+        s += "    LOAD 0\n";
+        s += "    PUSH " + std::to_string(block % 1000) + "\n";
+        s += "    IADD\n";
+        s += "    DUP\n";
+        s += "    STORE 0\n";
+        s += "    JNZ L" + std::to_string(block) + "\n";
+        n += 6;
+    }
+    return s;
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::string src = generate(count);
+
+    assembler::Interner names;
+    Tokenizer tokenizer(src, &names);
+    Parser parser(tokenizer, names);
+    std::vector<Instruction> instrs = parser.parse();
+
+    assembler::stats::enable();
+    {
+        assembler::stats::Phase phase("copy");
+        std::vector<Instruction> copy = instrs;
+        (void)copy;
+    }
+    const auto& r = assembler::stats::phases().back();
+    double n = (double)instrs.size();
+
+    std::printf("instructions:        %zu\n", instrs.size());
+    std::printf("sizeof(Instruction): %zu\n", sizeof(Instruction));
+    std::printf("sizeof(Operand):     %zu\n", sizeof(Operand));
+    std::printf("allocs/instr:        %.2f\n", r.allocs / n);
+    std::printf("heap bytes/instr:    %.1f (peak live, incl. malloc overhead)\n",
+                r.peak_bytes / n);
+    return 0;
+}
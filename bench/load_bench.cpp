@@ -0,0 +1,134 @@
+// ============================================================================
+// load_bench.cpp - VM start-up time: loading a .vm file until it can run
+//
+//   bin/load_bench <file.vm> <copy|map|verify> [repeats]
+//
+// copy:   read the whole file and decode the pool, classes, fields and
+//         methods into owned structures, as a loader that cannot use the
+//         file in place has to
+// map:    VMImage::open, then what running needs first: main's frame sizes,
+//         the first class's name and pool entry #1
+// verify: map plus VMImage::verify
+//
+// Before each run the file's pages are dropped from the page cache where
+// the OS allows it (POSIX_FADV_DONTNEED), so the times approximate a cold
+// start. Reports the best and the median of `repeats` runs.
+// ============================================================================
+#include "assembler/VMLoader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace assembler;
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static void drop_cache(const std::string& path) {
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#else
+    (void)path;
+#endif
+}
+
+struct OwnedClass {
+    std::string name;
+    uint32_t    super;
+    std::vector<std::pair<std::string, uint32_t>> fields;
+    std::vector<std::pair<std::string, MethodRecord>> methods;
+};
+
+// The copy-everything loader: owned code, constants and class structures.
+static std::size_t load_copy(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+    // The read brought the file into the page cache; decode it through the
+    // loader's accessors into owned structures.
+    VMImage image;
+    std::string err;
+    if (!image.open(path, err)) return 0;
+    std::vector<uint8_t> code(image.code(), image.code() + image.code_size());
+    std::vector<std::pair<std::string, MethodRecord>> functions;
+    for (uint32_t i = 0; i < image.function_count(); ++i) {
+        MethodRecord f = image.function_at(i);
+        functions.emplace_back(std::string(image.string_at(f.name)), f);
+    }
+    std::vector<std::string> pool;
+    for (uint32_t n = 1; n <= image.pool_count(); ++n) {
+        PoolConstant c;
+        image.constant(n, c);
+        pool.emplace_back(c.str);
+    }
+    std::vector<OwnedClass> classes(image.class_count());
+    for (uint32_t i = 0; i < image.class_count(); ++i) {
+        ClassRecord r = image.class_at(i);
+        OwnedClass& c = classes[i];
+        c.name = std::string(image.string_at(r.name));
+        c.super = r.super;
+        for (uint32_t f = 0; f < r.field_count; ++f) {
+            FieldRecord fr = image.field_at(r.first_field + f);
+            c.fields.emplace_back(std::string(image.string_at(fr.name)), fr.pool_index);
+        }
+        for (uint32_t m = 0; m < r.method_count; ++m) {
+            MethodRecord mr = image.method_at(r.first_method + m);
+            c.methods.emplace_back(std::string(image.string_at(mr.name)), mr);
+        }
+    }
+    return file.size() + code.size() + functions.size() + pool.size() + classes.size();
+}
+
+static std::size_t load_map(const std::string& path, bool verify) {
+    VMImage image;
+    std::string err;
+    if (!image.open(path, err) || (verify && !image.verify(err))) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), err.c_str());
+        std::exit(1);
+    }
+    std::size_t seen = image.entry_point();
+    MethodRecord main;
+    if (image.find_function("main", main)) seen += main.max_stack + main.max_locals;
+    if (image.class_count()) seen += image.string_at(image.class_at(0).name).size();
+    PoolConstant c;
+    if (image.constant(1, c)) seen += c.bits;
+    return seen;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: load_bench <file.vm> <copy|map|verify> [repeats]\n");
+        return 1;
+    }
+    std::string path = argv[1], mode = argv[2];
+    int repeats = argc > 3 ? std::atoi(argv[3]) : 20;
+
+    std::vector<double> times;
+    std::size_t sink = 0;
+    for (int r = 0; r < repeats; ++r) {
+        drop_cache(path);
+        auto t0 = Clock::now();
+        if (mode == "copy") sink += load_copy(path);
+        else sink += load_map(path, mode == "verify");
+        times.push_back(since(t0));
+    }
+    std::sort(times.begin(), times.end());
+    std::printf("%-6s best %8.3f ms   median %8.3f ms   (%zu)\n", mode.c_str(),
+                times.front() * 1e3, times[times.size() / 2] * 1e3, sink % 10);
+    return 0;
+}
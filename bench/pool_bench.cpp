@@ -0,0 +1,75 @@
+// ============================================================================
+// pool_bench.cpp - constant pool add and emit throughput
+//
+//   bin/pool_bench [adds] [repeats]
+//
+// Adds `adds` constants (a mix of ints, floats and short strings, about
+// half of them repeats) to a fresh pool, then lays out its string table and
+// serializes both, and reports the best of `repeats` runs. The checksum of
+// the emitted bytes lets two pool implementations be compared for
+// identical output.
+// ============================================================================
+#include "assembler/ConstantPool.hpp"
+#include "assembler/StringTable.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    size_t adds    = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 3000000;
+    int    repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    // Inputs are built up front so only the pool is timed.
+    size_t distinct = adds / 2 + 1;
+    std::vector<std::string> strings;
+    strings.reserve(distinct / 3 + 1);
+    for (size_t i = 0; i < distinct / 3 + 1; ++i) strings.push_back("str_" + std::to_string(i));
+
+    double best_add = 1e30, best_emit = 1e30;
+    size_t entries = 0, bytes = 0;
+    uint64_t checksum = 0;
+    for (int r = 0; r < repeats; ++r) {
+        assembler::ConstantPool pool;
+        auto t0 = Clock::now();
+        for (size_t i = 0; i < adds; ++i) {
+            size_t k = (i * 2654435761u) % distinct;
+            switch (k % 3) {
+                case 0: pool.add_int(static_cast<int32_t>(k)); break;
+                case 1: pool.add_float(static_cast<float>(k) * 0.5f); break;
+                case 2: pool.add_string(strings[k / 3]); break;
+            }
+        }
+        double add_s = seconds_since(t0);
+
+        std::vector<uint8_t> buf;
+        t0 = Clock::now();
+        assembler::StringTable table;
+        pool.add_strings(table);
+        table.finish();
+        pool.emit(buf, table);
+        buf.insert(buf.end(), table.data().begin(), table.data().end());
+        double emit_s = seconds_since(t0);
+
+        if (add_s < best_add) best_add = add_s;
+        if (emit_s < best_emit) best_emit = emit_s;
+        entries = pool.entries().size();
+        bytes = buf.size();
+        checksum = 14695981039346656037ull;
+        for (uint8_t b : buf) checksum = (checksum ^ b) * 1099511628211ull;
+    }
+
+    std::printf("adds:      %zu (%zu distinct entries)\n", adds, entries);
+    std::printf("add:       %.1f ms, %.1f M adds/s\n", best_add * 1e3, adds / best_add / 1e6);
+    std::printf("emit:      %.1f ms, %.1f MB/s (%zu bytes)\n", best_emit * 1e3,
+                bytes / best_emit / 1e6, bytes);
+    std::printf("checksum:  %016llx\n", (unsigned long long)checksum);
+    return 0;
+}
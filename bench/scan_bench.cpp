@@ -0,0 +1,76 @@
+// ============================================================================
+// scan_bench.cpp - whitespace/comment scanning throughput per ISA
+//
+//   bin/scan_bench [megabytes]
+//
+// Runs the raw scanners and a full Tokenizer::tokenize over generated source
+// that is roughly 40% comments and indentation, once per supported ISA.
+// ============================================================================
+#include "assembler/Scan.hpp"
+#include "assembler/Tokenizer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace assembler;
+
+static std::string generate(size_t bytes) {
+    std::string s;
+    s.reserve(bytes + 256);
+    unsigned n = 0;
+    while (s.size() < bytes) {
+        s += "L" + std::to_string(n) + ":\n";
+        s += "        LOAD 0                  ; Post-Increment: load original value\n";
+        s += "        PUSH 1\n";
+        s += "        IADD\n";
+        s += "\n";
+        s += "        STORE 0                 ; Post-Increment: store new value\n";
+        s += "        // ------------------------------------------------\n";
+        s += "        JNZ L" + std::to_string(n) + "\n";
+        ++n;
+    }
+    return s;
+}
+
+template <typename F>
+static double seconds(F&& f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char** argv) {
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    std::string src = generate(mb << 20);
+    const double size_mb = (double)src.size() / (1 << 20);
+
+    std::printf("%-8s %14s %14s %14s\n", "isa", "scan MB/s", "tokenize MB/s", "tokens");
+    for (scan::Isa isa : {scan::Isa::Scalar, scan::Isa::SSE2, scan::Isa::AVX2}) {
+        if (!scan::set_isa(isa)) continue;
+
+        // Alternate between the two scanners the way the tokenizer does:
+        // skip blanks, then jump to the end of the line.
+        size_t lines = 0;
+        double scan_s = seconds([&] {
+            size_t pos = 0;
+            while (pos < src.size()) {
+                pos = scan::skip_space(src.data(), pos, src.size()).end;
+                pos = scan::find_newline(src.data(), pos, src.size());
+                ++lines;
+            }
+        });
+
+        size_t ntok = 0;
+        double tok_s = seconds([&] {
+            Tokenizer t(src);
+            ntok = t.tokenize().size();
+        });
+
+        std::printf("%-8s %14.1f %14.1f %14zu\n", scan::isa_name(isa),
+                    size_mb / scan_s, size_mb / tok_s, ntok);
+        if (lines == 0) std::printf("(empty input)\n");
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+// ============================================================================
+// tokenizer_bench.cpp - tokens/sec and peak RSS of Tokenizer::tokenize
+//
+//   bin/tokenizer_bench [megabytes] [jobs]
+//
+// Generates compiler-style assembly (indentation, trailing comments, labels)
+// in memory and tokenizes it once.
+// ============================================================================
+#include "assembler/Tokenizer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static long peak_rss_kb() {
+#ifndef _WIN32
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+static std::string generate(size_t bytes) {
+    std::string s;
+    s.reserve(bytes + 256);
+    unsigned n = 0;
+    while (s.size() < bytes) {
+        s += "L" + std::to_string(n) + ":\n";
+        s += "    LOAD 0          ; Load a\n";
+        s += "    PUSH " + std::to_string(n % 1000) + "\n";
+        s += "    IADD\n";
+        s += "    STORE 0         ; Store to a\n";
+        s += "    // loop back edge\n";
+        s += "    JNZ L" + std::to_string(n) + "\n";
+        ++n;
+    }
+    return s;
+}
+
+int main(int argc, char** argv) {
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    unsigned jobs = argc > 2 ? (unsigned)std::strtoul(argv[2], nullptr, 10) : 1;
+    std::string src = generate(mb << 20);
+    long rss_before = peak_rss_kb();
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto toks = jobs > 1 ? Tokenizer::tokenize_parallel(src, jobs)
+                         : Tokenizer(src).tokenize();
+    auto t1 = std::chrono::steady_clock::now();
+
+    double secs = std::chrono::duration<double>(t1 - t0).count();
+    std::printf("input:        %zu MB, %u job(s)\n", mb, jobs);
+    std::printf("tokens:       %zu\n", toks.size());
+    std::printf("time:         %.3f s\n", secs);
+    std::printf("tokens/sec:   %.1f M\n", toks.size() / secs / 1e6);
+    std::printf("MB/sec:       %.1f\n", (double)src.size() / (1 << 20) / secs);
+    std::printf("peak RSS:     %ld MB (source alone: %ld MB)\n",
+                peak_rss_kb() >> 10, rss_before >> 10);
+    return 0;
+}
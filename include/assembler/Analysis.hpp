@@ -0,0 +1,64 @@
+// ============================================================================
+// Analysis.hpp - per-method control-flow graph, stack depth and locals
+// ============================================================================
+#ifndef ASSEMBLER_Analysis_hpp
+#define ASSEMBLER_Analysis_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "assembler/Instruction.hpp"
+#include "assembler/SymbolTable.hpp"
+
+namespace assembler {
+
+constexpr uint32_t NO_BLOCK = UINT32_MAX;
+
+// Instructions [first, end) of a method, entered only at `first` and left
+// only from the last one.
+struct BasicBlock {
+    uint32_t first;
+    uint32_t end;
+    uint32_t succ[2] = {NO_BLOCK, NO_BLOCK};   // fall-through, branch target
+};
+
+struct MethodCfg {
+    std::vector<BasicBlock> blocks;     // blocks[0] is the entry
+    std::vector<uint32_t>   block_of;   // instruction - method.first_instr -> block
+    bool complete = true;               // false: a branch leaves the method or
+                                        // has no known label target
+};
+
+// Splits the instructions of `method` (which must have an instruction
+// range) into basic blocks and links them by fall-through and branches.
+MethodCfg build_cfg(const std::vector<Instruction>& program, const SymbolTable& symtab,
+                    const MethodInfo& method);
+
+// Local slot that `ins` reads or writes (LOAD, STORE, IINC), -1 if it
+// touches none, or -2 if the slot is not an immediate.
+int64_t local_slot(const Instruction& ins);
+
+// Number of local slots `method` needs: its highest slot plus one, or
+// NO_INDEX if a slot operand is not an immediate.
+uint32_t locals_used(const std::vector<Instruction>& program, const MethodInfo& method);
+
+struct StackReport {
+    SymbolId    method = NO_SYMBOL;
+    uint32_t    max_depth = 0;      // deepest operand stack on any path
+    uint32_t    returns = 0;        // values left on the stack by RET
+    bool        known = true;       // false: a call's stack effect is unknown, or
+                                    // the CFG is incomplete (MethodCfg::complete)
+    std::vector<std::string> problems;   // underflows and depth mismatches
+};
+
+// Runs a stack-depth dataflow over every method with an instruction range.
+// Stack effects come from the opcode table; a call pops the callee's
+// arguments (one per slot up to its highest LOAD_ARG) and pushes what the
+// callee's RET leaves. Methods whose CFG is incomplete are reported as not
+// known. Reports are ordered by method entry.
+std::vector<StackReport> analyze_stack(const std::vector<Instruction>& program,
+                                       const SymbolTable& symtab);
+
+} // namespace assembler
+
+#endif // ASSEMBLER_Analysis_hpp
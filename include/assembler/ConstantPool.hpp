@@ -6,13 +6,15 @@
 #define ASSEMBLER_ConstantPool_hpp
 
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 #include <iostream>
 
 namespace assembler {
 
+class StringTable;
+
 // Tags for our VM constant pool
 enum class ConstTag : uint8_t {
     INT    = 1,
@@ -20,11 +22,13 @@ enum class ConstTag : uint8_t {
     STRING = 3   // UTF8 literal
 };
 
-// Constant pool entry
+// Constant pool entry, stored in typed form: ints and floats inline,
+// string bytes in the pool's shared blob.
 struct ConstEntry {
     ConstTag tag;
-    int index;            // pool index (starts at 1)
-    std::string str;      // literal stored as string
+    uint32_t index;       // pool index (starts at 1)
+    uint32_t bits;        // INT: the value, FLOAT: IEEE-754 bits, STRING: blob offset
+    uint32_t length;      // STRING: byte length, else 0
 };
 
 class ConstantPool {
@@ -32,24 +36,67 @@ public:
     // Add primitive literals
     int add_int(int32_t v);
     int add_float(float f);
-    int add_string(const std::string &s);
+    int add_string(std::string_view s);
+
+    // Room for `entries` constants and `string_bytes` of string data
+    void reserve(std::size_t entries, std::size_t string_bytes = 0);
 
     // Access entries
     const std::vector<ConstEntry>& entries() const { return pool_; }
+    int32_t          int_value(const ConstEntry& e) const { return static_cast<int32_t>(e.bits); }
+    float            float_value(const ConstEntry& e) const;
+    std::string_view string_value(const ConstEntry& e) const {
+        return std::string_view(blob_.data() + e.bits, e.length);
+    }
+    // The value as dumps print it: decimal, 0x-prefixed float bits, or the
+    // string itself
+    std::string text(const ConstEntry& e) const;
 
-    // Serialize constant pool into binary
-    void emit(std::vector<uint8_t> &buf) const;
+    // Adds every string constant to `strings`
+    void add_strings(StringTable& strings) const;
 
-    // Calculate size in bytes
+    // Serialize the constant pool section (appends to `buf`):
+    //
+    //   u32 count
+    //   u32 offset[count]   offset of entry #n+1 from the section start
+    //   entries             u8 tag, u32 index, then u32 value, or for a
+    //                       string u32 length and u32 string-table offset
+    //
+    // All integers are little-endian. The offset table is fixed-width, so a
+    // loader finds any #n with one array access. `strings` must be finished
+    // and hold every string constant.
+    void emit(std::vector<uint8_t> &buf, const StringTable& strings) const;
+
+    // Size of the emitted section in bytes
     uint32_t size_bytes() const;
 
     // Debug print
     void print() const;
 
 private:
+    // What an entry is deduplicated on: its tag and raw bits, or for a
+    // string its bytes. Lookups probe with a Key, so nothing is built or
+    // allocated to find an existing constant.
+    struct Key {
+        ConstTag         tag;
+        uint32_t         bits;
+        std::string_view str;
+    };
+    static uint64_t hash(const Key& k);
+    bool same(const ConstEntry& e, const Key& k) const;
+    int  add(const Key& k);
+    void grow();
+
     std::vector<ConstEntry> pool_;
-    std::unordered_map<std::string, int> lookup_; // deduplication
-    int next_index_ = 1; // pool indices start at 1
+    std::string             blob_;     // bytes of every string constant
+    uint32_t                string_count_ = 0;
+    // Open addressing. A slot keeps the entry's hash so probes and rehashes
+    // rarely touch the entries themselves.
+    struct Slot {
+        uint32_t pos;     // pool_ position + 1, 0 = empty
+        uint32_t hash;    // high half of hash()
+    };
+    std::vector<Slot>       slots_;
 };
 
 } // namespace assembler
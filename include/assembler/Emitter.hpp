@@ -4,45 +4,45 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include "SymbolTable.hpp"
+#include "StringTable.hpp"
 
 namespace assembler {
 
-struct Header {
-    uint32_t magic;
-    uint32_t version;
-    uint32_t entryPoint;
-    uint32_t constPoolOffset;
-    uint32_t constPoolSize;
-    uint32_t codeOffset;
-    uint32_t codeSize;
-    uint32_t globalsOffset;
-    uint32_t globalsSize;
-    uint32_t classMetadataOffset;
-    uint32_t classMetadataSize;
-};
-
+// Builds a section in memory. Integers are written little-endian.
 class BinaryWriter {
     std::vector<uint8_t> buf;
 
 public:
-    template <typename T>
-    void write(const T& val) {
-        T tmp = val;
-        uint8_t* p = (uint8_t*)&tmp;
-        buf.insert(buf.end(), p, p + sizeof(T));
-    }
-
-    void writeBytes(const std::vector<uint8_t>& v);
-    void writeString(const std::string& s);
+    void write(uint32_t v);
     const std::vector<uint8_t>& data() const { return buf; }
 };
 
-// Directly write VM file from SymbolTable
-void writeVMFile(
+// Adds the class, field, method and function names the metadata refers to.
+void addMetadataNames(const SymbolTable& symtab, StringTable& strings);
+
+// The order classes are written in: by name, except that a superclass
+// always comes before its subclasses. It depends only on the program, so
+// the same source gives byte-identical metadata. Superclass cycles, which
+// have no such order, are appended to `errors` when it is given.
+std::vector<const ClassInfo*> metadataOrder(const SymbolTable& symtab,
+                                            std::vector<std::string>* errors = nullptr);
+
+// Methods that belong to no class, by name: the FUNCTIONS section.
+std::vector<const MethodInfo*> functionOrder(const SymbolTable& symtab);
+
+// Directly write VM file from SymbolTable in the container VMFormat.hpp
+// describes; `pool` (a section from ConstantPool::emit) and `code` are
+// written as they are, without being copied. Names in the metadata are
+// offsets into `strings`, which must be finished. Returns false, after
+// logging why, if the file could not be written.
+bool writeVMFile(
     const std::string& filename,
+    const std::vector<uint8_t>& pool,
     const std::vector<uint8_t>& code,
-    const SymbolTable& symtab
+    const SymbolTable& symtab,
+    const StringTable& strings
 );
 
 } // namespace assembler
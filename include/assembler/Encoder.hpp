@@ -0,0 +1,57 @@
+// ============================================================================
+// Encoder.hpp - instructions straight to code-section bytes
+// ============================================================================
+#ifndef ASSEMBLER_Encoder_hpp
+#define ASSEMBLER_Encoder_hpp
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include "assembler/Instruction.hpp"
+#include "assembler/Interner.hpp"
+#include "assembler/SymbolTable.hpp"
+
+namespace assembler {
+
+// Where each encoded instruction starts and which source line produced it.
+// Kept beside the bytes rather than inside them, for diagnostics and dumps.
+struct SourceLoc {
+    uint32_t offset;    // byte offset of the opcode in the code section
+    int      line;
+    int      col;
+};
+
+class Encoder {
+public:
+    struct Report {
+        std::vector<std::string> errors;
+        std::vector<uint8_t>     code;   // exactly `code_size` bytes
+        std::vector<SourceLoc>   locs;   // one per instruction
+    };
+
+    // Encodes `program` into a buffer of `code_size` bytes, normally the
+    // location counter after layout, allocated once up front. Operand
+    // widths come from the opcode table. Label operands named by a resolved
+    // fixup take the fixup's value; any other label operand must spell a
+    // number (`names` resolves its text). Operands that cannot be encoded,
+    // including values that do not fit their slot, are left zero-filled
+    // and reported, so every later address stays where layout put it.
+    static Report encode(const std::vector<Instruction>& program, const Interner& names,
+                         const std::vector<Fixup>& fixups, std::size_t code_size);
+};
+
+// Little-endian operand of `width` bytes at `p`, sign-extended if
+// `is_signed`. 4-byte operands always read as int32_t.
+inline int32_t read_operand(const uint8_t* p, unsigned width, bool is_signed) {
+    uint32_t v = 0;
+    for (unsigned b = 0; b < width; ++b) v |= (uint32_t)p[b] << (8 * b);
+    if (is_signed && width < 4) {
+        uint32_t sign = 1u << (8 * width - 1);
+        v = (v ^ sign) - sign;
+    }
+    return static_cast<int32_t>(v);
+}
+
+} // namespace assembler
+
+#endif // ASSEMBLER_Encoder_hpp
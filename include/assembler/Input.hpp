@@ -0,0 +1,76 @@
+// ============================================================================
+// Input.hpp - source input: memory-mapped files and chunked stream reads
+// ============================================================================
+#ifndef ASSEMBLER_Input_hpp
+#define ASSEMBLER_Input_hpp
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace assembler {
+
+// The source text of one assembly unit. Regular files are mapped read-only
+// (with a sequential-access hint) and exposed through text(); pipes, ttys
+// and stdin ("-") are left unmapped and must be streamed from fd() through
+// a StreamBuffer. Owns the mapping and the descriptor.
+class SourceFile {
+public:
+    SourceFile() = default;
+    ~SourceFile();
+    SourceFile(SourceFile&& other) noexcept;
+    SourceFile& operator=(SourceFile&& other) noexcept;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    // `path` "-" means standard input.
+    static SourceFile open(const std::string& path);
+
+    bool ok() const { return fd_ >= 0; }
+    bool mapped() const { return data_ != nullptr; }
+    std::string_view text() const { return {data_, size_}; }
+    int fd() const { return fd_; }
+
+private:
+    void release();
+
+    int         fd_ = -1;
+    bool        owns_fd_ = false;
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// A sliding window over a file descriptor. The Tokenizer consumes the
+// window and asks for more with refill(); everything before `keep` is
+// dropped, the rest is moved to the front and the free space is filled with
+// one read(). The buffer only grows when a single token is larger than it.
+class StreamBuffer {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit StreamBuffer(int fd, std::size_t capacity = DEFAULT_CAPACITY);
+
+    // Current window. Invalidated by refill().
+    std::string_view window() const { return {buf_.data(), len_}; }
+
+    // Drops window()[0, keep) and reads more input behind what is left.
+    // Returns false once the input is exhausted or a read fails.
+    bool refill(std::size_t keep);
+
+    // The errno of the read that failed, 0 if input simply ran out.
+    int error() const { return error_; }
+
+    std::size_t capacity() const { return buf_.size(); }
+
+private:
+    int               fd_;
+    bool              eof_ = false;
+    int               error_ = 0;
+    std::vector<char> buf_;
+    std::size_t       len_ = 0;
+};
+
+} // namespace assembler
+
+#endif // ASSEMBLER_Input_hpp
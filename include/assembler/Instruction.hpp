@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include "assembler/Interner.hpp"
+#include "assembler/SmallVector.hpp"
 
 enum class OpCode : uint8_t {
     // Int arithmetic
@@ -22,6 +24,8 @@ enum class OpCode : uint8_t {
     // Control flow
     JMP = 0x30, JZ = 0x31, JNZ = 0x32,
     CALL = 0x33, RET = 0x34,
+    JMP_S = 0x35, JZ_S = 0x36, JNZ_S = 0x37,     // rel8 from the next instruction
+    JMP_W = 0x38, JZ_W = 0x39, JNZ_W = 0x3A,     // absolute 32-bit target
 
     // Int comparisons
     ICMP_EQ = 0x40, ICMP_LT = 0x41, ICMP_GT = 0x42,
@@ -38,11 +42,25 @@ enum class OpCode : uint8_t {
     INVOKEVIRTUAL = 0x53,
     INVOKESPECIAL = 0x54,
 
+    // Superinstructions (see Fusion.cpp)
+    IINC = 0x60,                                 // slot u8, delta s8
+    IF_ICMPEQ = 0x61, IF_ICMPLT = 0x62, IF_ICMPGT = 0x63,    // rel16 from the
+    IF_ICMPGEQ = 0x64, IF_ICMPNEQ = 0x65, IF_ICMPLEQ = 0x66, // next instruction
+    IF_ICMPEQ_W = 0x67, IF_ICMPLT_W = 0x68, IF_ICMPGT_W = 0x69,    // absolute
+    IF_ICMPGEQ_W = 0x6A, IF_ICMPNEQ_W = 0x6B, IF_ICMPLEQ_W = 0x6C, // 32-bit
+
     INVALID = 0xFF
 };
 
+// Class/field/descriptor names of a field reference, as interned ids.
+struct FieldRefOperand {
+    assembler::SymbolId clazz, name, desc;
+};
+
+// 16 bytes: a tag plus a payload selected by it. Names are interned
+// (see Interner.hpp), so operands never own heap memory.
 struct Operand {
-    enum class Kind {
+    enum class Kind : uint8_t {
         Register,
         Immediate,
         Label,
@@ -52,16 +70,41 @@ struct Operand {
     };
 
     Kind kind {Kind::Immediate};
-    int reg = -1;
-    int imm = 0;
-    int pool_index = -1;
-    std::string label;
-    struct { std::string clazz, name, desc; } fieldref;
+    union {
+        int32_t             imm;          // Immediate
+        int32_t             reg;          // Register
+        int32_t             pool_index;   // ConstPoolIndex
+        assembler::SymbolId sym;          // Label, MethodRef
+        FieldRefOperand     fieldref;     // FieldRef
+    };
+
+    Operand() : imm(0) {}
+
+    static Operand immediate(int32_t v) {
+        Operand op;
+        op.kind = Kind::Immediate;
+        op.imm = v;
+        return op;
+    }
+    static Operand label(assembler::SymbolId s) {
+        Operand op;
+        op.kind = Kind::Label;
+        op.sym = s;
+        return op;
+    }
+    static Operand constpool(int32_t index) {
+        Operand op;
+        op.kind = Kind::ConstPoolIndex;
+        op.pool_index = index;
+        return op;
+    }
 };
 
+static_assert(sizeof(Operand) == 16, "Operand should stay a 16-byte value");
+
 struct Instruction {
     OpCode op {OpCode::INVALID};
-    std::vector<Operand> operands;
+    assembler::SmallVector<Operand, 2> operands;   // inline up to two operands
     int src_line {0};
     int src_col {0};
 };
@@ -69,33 +112,4 @@ struct Instruction {
 std::string opcode_to_string(OpCode oc);
 OpCode mnemonic_to_opcode(const std::string &m);
 
-inline std::size_t encoded_size(const Instruction& ins) {
-    switch (ins.op) {
-        // no operand
-        case OpCode::IADD: case OpCode::ISUB: case OpCode::IMUL:
-        case OpCode::IDIV: case OpCode::INEG:
-        case OpCode::FADD: case OpCode::FSUB: case OpCode::FMUL:
-        case OpCode::FDIV: case OpCode::FNEG:
-        case OpCode::POP:  case OpCode::DUP:
-        case OpCode::FPOP:
-        case OpCode::RET:
-        case OpCode::ICMP_EQ: case OpCode::ICMP_LT: case OpCode::ICMP_GT:
-        case OpCode::ICMP_GEQ: case OpCode::ICMP_NEQ: case OpCode::ICMP_LEQ:
-        case OpCode::FCMP_EQ: case OpCode::FCMP_LT: case OpCode::FCMP_GT:
-        case OpCode::FCMP_GEQ: case OpCode::FCMP_NEQ: case OpCode::FCMP_LEQ:
-            return 1;
-
-        // has 4-byte operand
-        case OpCode::PUSH: case OpCode::FPUSH:
-        case OpCode::LOAD: case OpCode::STORE: case OpCode::LOAD_ARG:
-        case OpCode::JMP: case OpCode::JZ: case OpCode::JNZ: case OpCode::CALL:
-        case OpCode::NEW: case OpCode::GETFIELD: case OpCode::PUTFIELD:
-        case OpCode::INVOKEVIRTUAL: case OpCode::INVOKESPECIAL:
-            return 1 + 4;
-
-        default:
-            return 1;
-    }
-}
-
 #endif // ASSEMBLER_Instruction_hpp
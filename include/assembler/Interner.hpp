@@ -0,0 +1,51 @@
+// ============================================================================
+// Interner.hpp - identifier interning: one copy and one dense id per name
+// ============================================================================
+#ifndef ASSEMBLER_Interner_hpp
+#define ASSEMBLER_Interner_hpp
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace assembler {
+
+using SymbolId = uint32_t;
+constexpr SymbolId NO_SYMBOL = UINT32_MAX;
+
+// Maps names to dense ids (0, 1, 2, ...) in first-seen order. The bytes
+// live in append-only blocks, so views returned by name() stay valid for
+// the interner's lifetime.
+class Interner {
+public:
+    Interner() = default;
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    SymbolId intern(std::string_view s);
+
+    // NO_SYMBOL if `s` was never interned.
+    SymbolId find(std::string_view s) const;
+
+    // NO_SYMBOL reads as the empty name.
+    std::string_view name(SymbolId id) const {
+        return id == NO_SYMBOL ? std::string_view() : names_[id];
+    }
+    std::size_t size() const { return names_.size(); }
+
+private:
+    static constexpr std::size_t BLOCK = 64 * 1024;
+
+    std::string_view store(std::string_view s);
+
+    std::vector<std::unique_ptr<char[]>>          blocks_;
+    std::size_t                                   block_used_ = BLOCK;
+    std::vector<std::string_view>                 names_;
+    std::unordered_map<std::string_view, SymbolId> ids_;
+};
+
+} // namespace assembler
+
+#endif // ASSEMBLER_Interner_hpp
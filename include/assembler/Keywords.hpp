@@ -0,0 +1,146 @@
+// ============================================================================
+// Keywords.hpp - compile-time perfect hash over mnemonics and directives
+// ============================================================================
+#ifndef ASSEMBLER_Keywords_hpp
+#define ASSEMBLER_Keywords_hpp
+
+#include "assembler/Instruction.hpp"
+#include "assembler/Opcodes.hpp"
+#include <cstdint>
+#include <string_view>
+
+enum class Directive : uint8_t {
+    NONE,
+    DATA, TEXT, WORD, CONST,
+    CLASS, ENDCLASS, SUPER, FIELD,
+    METHOD, ENDMETHOD, LIMIT, END,
+};
+
+// One entry per reserved word. Mnemonics carry their OpCode, directives
+// (which always start with '.') their Directive.
+struct Keyword {
+    std::string_view name;   // canonical spelling (upper-case mnemonics)
+    OpCode           op;
+    Directive        dir;
+};
+
+namespace keywords {
+
+constexpr Keyword DIRECTIVES[] = {
+    {".data", OpCode::INVALID, Directive::DATA},
+    {".text", OpCode::INVALID, Directive::TEXT},
+    {".word", OpCode::INVALID, Directive::WORD},
+    {".const", OpCode::INVALID, Directive::CONST},
+    {".class", OpCode::INVALID, Directive::CLASS},
+    {".endclass", OpCode::INVALID, Directive::ENDCLASS},
+    {".super", OpCode::INVALID, Directive::SUPER},
+    {".field", OpCode::INVALID, Directive::FIELD},
+    {".method", OpCode::INVALID, Directive::METHOD},
+    {".endmethod", OpCode::INVALID, Directive::ENDMETHOD},
+    {".limit", OpCode::INVALID, Directive::LIMIT},
+    {".end", OpCode::INVALID, Directive::END},
+};
+
+constexpr std::size_t DIRECTIVE_COUNT = sizeof(DIRECTIVES) / sizeof(DIRECTIVES[0]);
+constexpr std::size_t COUNT = assembler::opcodes::COUNT + DIRECTIVE_COUNT;
+
+// Mnemonics come straight from the opcode table (Opcodes.hpp), followed by
+// the directives.
+struct Table {
+    Keyword entry[COUNT];
+    constexpr const Keyword& operator[](std::size_t i) const { return entry[i]; }
+};
+
+constexpr Table build_table() {
+    Table t{};
+    for (std::size_t i = 0; i < assembler::opcodes::COUNT; ++i) {
+        const assembler::OpcodeInfo& d = assembler::opcodes::TABLE[i];
+        t.entry[i] = Keyword{d.mnemonic, d.op, Directive::NONE};
+    }
+    for (std::size_t i = 0; i < DIRECTIVE_COUNT; ++i)
+        t.entry[assembler::opcodes::COUNT + i] = DIRECTIVES[i];
+    return t;
+}
+
+constexpr Table TABLE = build_table();
+
+constexpr std::size_t SLOTS = 512;          // power of two, ~7x COUNT
+constexpr std::size_t MAX_LEN = 16;         // longer identifiers never match
+
+constexpr bool fits_max_len() {
+    for (std::size_t i = 0; i < COUNT; ++i)
+        if (TABLE[i].name.size() > MAX_LEN) return false;
+    return true;
+}
+
+static_assert(COUNT < 255 && fits_max_len(), "keyword table outgrew its slot encoding");
+
+constexpr char fold(char c) {
+    return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+}
+
+// FNV-1a over the case-folded bytes, seeded so the table is collision free.
+constexpr uint32_t hash(std::string_view s, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : s) {
+        h ^= (unsigned char)fold(c);
+        h *= 16777619u;
+    }
+    return (h ^ (h >> 16)) & (uint32_t)(SLOTS - 1);
+}
+
+constexpr bool collision_free(uint32_t seed) {
+    bool used[SLOTS] = {};
+    for (std::size_t i = 0; i < COUNT; ++i) {
+        uint32_t h = hash(TABLE[i].name, seed);
+        if (used[h]) return false;
+        used[h] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t find_seed() {
+    uint32_t seed = 0;
+    while (!collision_free(seed)) ++seed;
+    return seed;
+}
+
+constexpr uint32_t SEED = find_seed();
+
+// slot -> index into TABLE + 1 (0 = empty)
+struct Slots { uint8_t index[SLOTS]; };
+
+constexpr Slots build_slots() {
+    Slots s{};
+    for (std::size_t i = 0; i < COUNT; ++i)
+        s.index[hash(TABLE[i].name, SEED)] = (uint8_t)(i + 1);
+    return s;
+}
+
+constexpr Slots SLOT_TABLE = build_slots();
+
+constexpr bool equal_folded(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (fold(a[i]) != fold(b[i])) return false;
+    return true;
+}
+
+} // namespace keywords
+
+// Case-insensitive keyword lookup: one hash, one compare, no allocation.
+// Returns nullptr for ordinary identifiers.
+constexpr const Keyword* find_keyword(std::string_view s) {
+    if (s.empty() || s.size() > keywords::MAX_LEN) return nullptr;
+    uint8_t i = keywords::SLOT_TABLE.index[keywords::hash(s, keywords::SEED)];
+    if (i == 0) return nullptr;
+    const Keyword& k = keywords::TABLE[i - 1];
+    return keywords::equal_folded(k.name, s) ? &k : nullptr;
+}
+
+static_assert(find_keyword("push") && find_keyword("push")->op == OpCode::PUSH,
+              "keyword perfect hash is broken");
+static_assert(find_keyword(".ENDMETHOD") && find_keyword(".ENDMETHOD")->dir == Directive::ENDMETHOD,
+              "keyword perfect hash is broken");
+
+#endif // ASSEMBLER_Keywords_hpp
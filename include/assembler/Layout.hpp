@@ -0,0 +1,41 @@
+// ============================================================================
+// Layout.hpp - instruction offsets and branch relaxation
+// ============================================================================
+#ifndef ASSEMBLER_Layout_hpp
+#define ASSEMBLER_Layout_hpp
+
+#include <cstdint>
+#include <vector>
+#include "assembler/Instruction.hpp"
+#include "assembler/SymbolTable.hpp"
+
+namespace assembler {
+
+// Code offset of each instruction of `program`, followed by the total size.
+std::vector<uint32_t> layout_offsets(const std::vector<Instruction>& program);
+
+// Whether a jump encoded as `op`, whose next instruction starts at
+// absolute address `next`, can reach absolute address `target`.
+bool reaches(OpCode op, int64_t target, int64_t next);
+
+struct RelaxReport {
+    std::vector<uint32_t> offsets;   // final layout, as from layout_offsets()
+    unsigned    passes = 0;          // layout passes until nothing grew
+    std::size_t rel8 = 0;            // jumps per chosen form
+    std::size_t abs16 = 0;
+    std::size_t abs32 = 0;
+    std::size_t rel16 = 0;           // fused compare-and-branch (IF_ICMPxx)
+};
+
+// Picks the smallest form of every label-targeted jump that still reaches
+// its target. All such jumps start in their smallest form (rel8 for
+// JMP/JZ/JNZ, rel16 for IF_ICMPxx); each pass recomputes the offsets and
+// widens the jumps that fall out of reach, up to an abs32 form that always
+// reaches. Jumps only ever grow, so this reaches a fixed point. The opcodes
+// in `program` are rewritten in place; the caller then moves labels and
+// methods with SymbolTable::relocate(report.offsets).
+RelaxReport relax_branches(std::vector<Instruction>& program, const SymbolTable& symtab);
+
+} // namespace assembler
+
+#endif // ASSEMBLER_Layout_hpp
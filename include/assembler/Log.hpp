@@ -0,0 +1,50 @@
+// ============================================================================
+// Log.hpp - leveled diagnostic logging
+// ============================================================================
+#ifndef ASSEMBLER_Log_hpp
+#define ASSEMBLER_Log_hpp
+
+#include <ostream>
+
+namespace assembler {
+namespace log {
+
+enum class Level : int { Error = 0, Warn, Info, Debug, Trace };
+
+// Messages above the current level are dropped before their arguments are
+// formatted. The default level is Warn and the default sink std::cerr.
+void set_level(Level lvl);
+Level level();
+inline bool enabled(Level lvl) { return static_cast<int>(lvl) <= static_cast<int>(level()); }
+
+void set_stream(std::ostream& out);
+std::ostream& stream();
+
+const char* level_name(Level lvl);
+
+} // namespace log
+} // namespace assembler
+
+#define ASM_LOG(lvl, expr)                                                    \
+    do {                                                                      \
+        if (::assembler::log::enabled(lvl))                                   \
+            ::assembler::log::stream()                                        \
+                << '[' << ::assembler::log::level_name(lvl) << "] " << expr   \
+                << '\n';                                                      \
+    } while (0)
+
+#define LOG_ERROR(expr) ASM_LOG(::assembler::log::Level::Error, expr)
+#define LOG_WARN(expr)  ASM_LOG(::assembler::log::Level::Warn, expr)
+#define LOG_INFO(expr)  ASM_LOG(::assembler::log::Level::Info, expr)
+
+// Debug and trace messages sit on hot paths (per token, per call site) and
+// are compiled out entirely in release (NDEBUG) builds.
+#ifdef NDEBUG
+#define LOG_DEBUG(expr) do {} while (0)
+#define LOG_TRACE(expr) do {} while (0)
+#else
+#define LOG_DEBUG(expr) ASM_LOG(::assembler::log::Level::Debug, expr)
+#define LOG_TRACE(expr) ASM_LOG(::assembler::log::Level::Trace, expr)
+#endif
+
+#endif // ASSEMBLER_Log_hpp
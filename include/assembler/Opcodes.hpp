@@ -0,0 +1,172 @@
+// ============================================================================
+// Opcodes.hpp - one descriptor per opcode: spelling, operand, width, stack
+// ============================================================================
+#ifndef ASSEMBLER_Opcodes_hpp
+#define ASSEMBLER_Opcodes_hpp
+
+#include "assembler/Instruction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace assembler {
+
+// What an operand of an instruction refers to.
+enum class OperandType : uint8_t {
+    None,
+    Int,        // 32-bit integer literal
+    Float,      // 32-bit float literal
+    Local,      // local variable slot
+    Arg,        // argument slot
+    Branch,     // code label, absolute address
+    RelBranch,  // code label, signed displacement from the next instruction
+    Method,     // method entry point
+    Class,      // class reference
+    Field,      // field reference
+};
+
+// Integer and displacement operands are signed; slots, addresses and
+// indices are not.
+constexpr bool is_signed(OperandType t) {
+    return t == OperandType::Int || t == OperandType::RelBranch;
+}
+
+// Stack effect that depends on the callee rather than on the opcode.
+constexpr int8_t VARIES = -1;
+
+struct OpcodeInfo {
+    OpCode           op;
+    std::string_view mnemonic;   // canonical upper-case spelling
+    OperandType      operand;
+    uint8_t          width;      // encoded operand bytes, 0 without operand
+    int8_t           pops;       // operand stack slots consumed (or VARIES)
+    int8_t           pushes;     // operand stack slots produced (or VARIES)
+    OperandType      operand2 = OperandType::None;   // second operand, if any
+    uint8_t          width2 = 0;
+
+    constexpr bool valid() const { return op != OpCode::INVALID; }
+    constexpr std::size_t operand_count() const {
+        return (operand != OperandType::None) + (operand2 != OperandType::None);
+    }
+    constexpr std::size_t size() const { return 1 + width + width2; }
+
+    constexpr OperandType operand_type(std::size_t i) const { return i ? operand2 : operand; }
+    constexpr unsigned operand_width(std::size_t i) const { return i ? width2 : width; }
+    // Byte offset of operand i from the opcode byte.
+    constexpr unsigned operand_offset(std::size_t i) const { return i ? 1 + width : 1; }
+};
+
+namespace opcodes {
+
+using T = OperandType;
+
+// The only place that says how an opcode is spelled, what it takes, how it
+// is encoded and what it does to the operand stack. Keywords.hpp, the parser
+// (location counter, validation) and the encoder all read from here.
+constexpr OpcodeInfo TABLE[] = {
+    {OpCode::IADD, "IADD", T::None, 0, 2, 1},   {OpCode::ISUB, "ISUB", T::None, 0, 2, 1},
+    {OpCode::IMUL, "IMUL", T::None, 0, 2, 1},   {OpCode::IDIV, "IDIV", T::None, 0, 2, 1},
+    {OpCode::INEG, "INEG", T::None, 0, 1, 1},
+
+    {OpCode::FADD, "FADD", T::None, 0, 2, 1},   {OpCode::FSUB, "FSUB", T::None, 0, 2, 1},
+    {OpCode::FMUL, "FMUL", T::None, 0, 2, 1},   {OpCode::FDIV, "FDIV", T::None, 0, 2, 1},
+    {OpCode::FNEG, "FNEG", T::None, 0, 1, 1},
+
+    {OpCode::PUSH,  "PUSH",  T::Int,   4, 0, 1}, {OpCode::POP,  "POP",  T::None, 0, 1, 0},
+    {OpCode::DUP,   "DUP",   T::None,  0, 1, 2}, {OpCode::FPOP, "FPOP", T::None, 0, 1, 0},
+    {OpCode::FPUSH, "FPUSH", T::Float, 4, 0, 1},
+
+    {OpCode::LOAD,     "LOAD",     T::Local, 4, 0, 1},
+    {OpCode::STORE,    "STORE",    T::Local, 4, 1, 0},
+    {OpCode::LOAD_ARG, "LOAD_ARG", T::Arg,   4, 0, 1},
+
+    {OpCode::JMP,  "JMP",  T::Branch, 2, 0, 0},
+    {OpCode::JZ,   "JZ",   T::Branch, 2, 1, 0},
+    {OpCode::JNZ,  "JNZ",  T::Branch, 2, 1, 0},
+    {OpCode::CALL, "CALL", T::Method, 4, VARIES, VARIES},
+    {OpCode::RET,  "RET",  T::None,   0, VARIES, 0},
+
+    // Short and wide jump forms; branch relaxation (Layout.hpp) picks the
+    // smallest one that reaches each target.
+    {OpCode::JMP_S, "JMP_S", T::RelBranch, 1, 0, 0},
+    {OpCode::JZ_S,  "JZ_S",  T::RelBranch, 1, 1, 0},
+    {OpCode::JNZ_S, "JNZ_S", T::RelBranch, 1, 1, 0},
+    {OpCode::JMP_W, "JMP_W", T::Branch,    4, 0, 0},
+    {OpCode::JZ_W,  "JZ_W",  T::Branch,    4, 1, 0},
+    {OpCode::JNZ_W, "JNZ_W", T::Branch,    4, 1, 0},
+
+    {OpCode::ICMP_EQ,  "ICMP_EQ",  T::None, 0, 2, 1}, {OpCode::ICMP_LT,  "ICMP_LT",  T::None, 0, 2, 1},
+    {OpCode::ICMP_GT,  "ICMP_GT",  T::None, 0, 2, 1}, {OpCode::ICMP_GEQ, "ICMP_GEQ", T::None, 0, 2, 1},
+    {OpCode::ICMP_NEQ, "ICMP_NEQ", T::None, 0, 2, 1}, {OpCode::ICMP_LEQ, "ICMP_LEQ", T::None, 0, 2, 1},
+
+    {OpCode::FCMP_EQ,  "FCMP_EQ",  T::None, 0, 2, 1}, {OpCode::FCMP_LT,  "FCMP_LT",  T::None, 0, 2, 1},
+    {OpCode::FCMP_GT,  "FCMP_GT",  T::None, 0, 2, 1}, {OpCode::FCMP_GEQ, "FCMP_GEQ", T::None, 0, 2, 1},
+    {OpCode::FCMP_NEQ, "FCMP_NEQ", T::None, 0, 2, 1}, {OpCode::FCMP_LEQ, "FCMP_LEQ", T::None, 0, 2, 1},
+
+    {OpCode::NEW,           "NEW",           T::Class,  4, 0, 1},
+    {OpCode::GETFIELD,      "GETFIELD",      T::Field,  4, 1, 1},
+    {OpCode::PUTFIELD,      "PUTFIELD",      T::Field,  4, 2, 0},
+    {OpCode::INVOKEVIRTUAL, "INVOKEVIRTUAL", T::Method, 4, VARIES, VARIES},
+    {OpCode::INVOKESPECIAL, "INVOKESPECIAL", T::Method, 4, VARIES, VARIES},
+
+    // Superinstructions, written by the fusion pass
+    {OpCode::IINC, "IINC", T::Local, 1, 0, 0, T::Int, 1},
+    {OpCode::IF_ICMPEQ,  "IF_ICMPEQ",  T::RelBranch, 2, 2, 0},
+    {OpCode::IF_ICMPLT,  "IF_ICMPLT",  T::RelBranch, 2, 2, 0},
+    {OpCode::IF_ICMPGT,  "IF_ICMPGT",  T::RelBranch, 2, 2, 0},
+    {OpCode::IF_ICMPGEQ, "IF_ICMPGEQ", T::RelBranch, 2, 2, 0},
+    {OpCode::IF_ICMPNEQ, "IF_ICMPNEQ", T::RelBranch, 2, 2, 0},
+    {OpCode::IF_ICMPLEQ, "IF_ICMPLEQ", T::RelBranch, 2, 2, 0},
+    {OpCode::IF_ICMPEQ_W,  "IF_ICMPEQ_W",  T::Branch, 4, 2, 0},
+    {OpCode::IF_ICMPLT_W,  "IF_ICMPLT_W",  T::Branch, 4, 2, 0},
+    {OpCode::IF_ICMPGT_W,  "IF_ICMPGT_W",  T::Branch, 4, 2, 0},
+    {OpCode::IF_ICMPGEQ_W, "IF_ICMPGEQ_W", T::Branch, 4, 2, 0},
+    {OpCode::IF_ICMPNEQ_W, "IF_ICMPNEQ_W", T::Branch, 4, 2, 0},
+    {OpCode::IF_ICMPLEQ_W, "IF_ICMPLEQ_W", T::Branch, 4, 2, 0},
+};
+
+constexpr std::size_t COUNT = sizeof(TABLE) / sizeof(TABLE[0]);
+
+constexpr OpcodeInfo NONE = {OpCode::INVALID, "INVALID", T::None, 0, 0, 0};
+
+// opcode byte -> descriptor, so lookups never search
+struct ByByte { OpcodeInfo info[256]; };
+
+constexpr ByByte build_by_byte() {
+    ByByte b{};
+    for (std::size_t i = 0; i < 256; ++i) b.info[i] = NONE;
+    for (std::size_t i = 0; i < COUNT; ++i) b.info[static_cast<uint8_t>(TABLE[i].op)] = TABLE[i];
+    return b;
+}
+
+constexpr ByByte BY_BYTE = build_by_byte();
+
+constexpr bool consistent() {
+    for (std::size_t i = 0; i < COUNT; ++i) {
+        const OpcodeInfo& d = TABLE[i];
+        if (!d.valid() || d.mnemonic.empty()) return false;
+        if ((d.operand == T::None) != (d.width == 0)) return false;
+        if ((d.operand2 == T::None) != (d.width2 == 0)) return false;
+        if (d.operand == T::None && d.operand2 != T::None) return false;
+        for (std::size_t j = 0; j < i; ++j)
+            if (TABLE[j].op == d.op || TABLE[j].mnemonic == d.mnemonic) return false;
+    }
+    return true;
+}
+
+static_assert(consistent(), "opcode table has a duplicate or inconsistent entry");
+
+} // namespace opcodes
+
+constexpr const OpcodeInfo& opcode_info(uint8_t byte) { return opcodes::BY_BYTE.info[byte]; }
+constexpr const OpcodeInfo& opcode_info(OpCode op) { return opcode_info(static_cast<uint8_t>(op)); }
+
+// Bytes an instruction occupies in the code section.
+constexpr std::size_t encoded_size(OpCode op) { return opcode_info(op).size(); }
+
+static_assert(encoded_size(OpCode::JMP) == 3 && encoded_size(OpCode::PUSH) == 5 &&
+              encoded_size(OpCode::RET) == 1, "opcode table is broken");
+
+} // namespace assembler
+
+#endif // ASSEMBLER_Opcodes_hpp
@@ -0,0 +1,117 @@
+// ============================================================================
+// Optimizer.hpp - optional passes over the parsed instruction stream
+// ============================================================================
+#ifndef ASSEMBLER_Optimizer_hpp
+#define ASSEMBLER_Optimizer_hpp
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "assembler/Instruction.hpp"
+#include "assembler/SymbolTable.hpp"
+
+namespace assembler {
+
+// Which passes run. They run after pass 1 and before layout, so labels
+// and methods are still instruction indices and every address is
+// computed from the optimized code.
+struct OptOptions {
+    bool peephole = false;        // -O
+    bool fold = false;            // -O: constant folding, algebraic identities
+    bool cfg = false;             // -O: jump threading, unreachable code, label merging
+    bool locals = false;          // -O: liveness-based local slot coalescing
+    bool fuse_iinc = false;       // LOAD n; PUSH k; IADD; STORE n -> IINC n,k
+    bool fuse_if_icmp = false;    // ICMP_xx; JNZ/JZ L -> IF_ICMPxx L
+
+    bool any() const { return peephole || fold || cfg || locals || fuse_iinc || fuse_if_icmp; }
+};
+
+// How often each opcode pair executed, e.g. from a VM profiling run.
+struct PairProfile {
+    std::unordered_map<uint16_t, uint64_t> counts;   // (first << 8) | second
+    uint64_t total = 0;
+
+    void add(OpCode a, OpCode b, uint64_t n);
+    uint64_t count(OpCode a, OpCode b) const;
+};
+
+// Reads "FIRST SECOND COUNT" lines of mnemonics and a count; '#' starts a
+// comment. Returns false and sets `error` on a malformed line.
+bool read_pair_profile(std::istream& in, PairProfile& profile, std::string& error);
+
+// Enables a fusion by name ("iinc", "if_icmp" or "all"); false if unknown.
+bool enable_fusion(const std::string& name, OptOptions& opts);
+
+// Enables every fusion whose idiom's opcode pairs make up at least
+// `min_share` of all pairs in `profile`; returns the names enabled.
+std::vector<std::string> select_fusions(const PairProfile& profile, double min_share,
+                                        OptOptions& opts);
+
+struct OptReport {
+    struct Rule {
+        std::string name;
+        std::size_t hits;
+    };
+    std::size_t      instrs_before = 0;
+    std::size_t      instrs_after = 0;
+    std::vector<Rule> rules;   // rules that fired, in first-hit order
+
+    void hit(const char* rule, std::size_t n = 1);
+};
+
+// Runs the passes selected in `opts` over `program`, keeping the symbol
+// table's labels, methods and fixups attached to the right instructions.
+void optimize(std::vector<Instruction>& program, SymbolTable& symtab,
+              const OptOptions& opts, OptReport& report);
+
+namespace opt {
+
+// Marks the instructions control can enter other than by falling through
+// from the previous one (label and method starts), plus the method ends.
+// Size program.size() + 1. A rewrite must not span one of these.
+std::vector<uint8_t> boundaries(const std::vector<Instruction>& program,
+                                const SymbolTable& symtab);
+
+// The label each instruction's branch fixup targets, or NO_SYMBOL.
+std::vector<SymbolId> branch_targets(const std::vector<Instruction>& program,
+                                     const SymbolTable& symtab);
+
+// Drops the instructions whose `keep` entry is 0. A label or method that
+// started at a dropped instruction moves to the next kept one; fixups of
+// dropped instructions are discarded.
+void compact(std::vector<Instruction>& program, SymbolTable& symtab,
+             const std::vector<uint8_t>& keep);
+
+// Folds int arithmetic, comparisons, INEG and JZ/JNZ on PUSHed literals
+// and drops identity operations (x+0, x-0, x*1, x/1, INEG INEG), within
+// straight-line code. Returns the rewrites made.
+std::size_t fold_constants(std::vector<Instruction>& program, SymbolTable& symtab,
+                           OptReport& report);
+
+// Control-flow cleanup: merges labels at the same instruction, threads
+// jumps through chains of JMPs to their final target and deletes the
+// instructions inside methods that no path reaches. Returns the changes made.
+std::size_t simplify_cfg(std::vector<Instruction>& program, SymbolTable& symtab,
+                         OptReport& report);
+
+// Pattern-driven peephole rewrites; returns the rewrites applied.
+std::size_t peephole(std::vector<Instruction>& program, SymbolTable& symtab,
+                     OptReport& report);
+
+// Superinstruction fusion for the fusions enabled in `opts`; returns the
+// fusions applied.
+std::size_t fuse(std::vector<Instruction>& program, SymbolTable& symtab,
+                 const OptOptions& opts, OptReport& report);
+
+// Renumbers each method's local slots so that slots whose live ranges do
+// not overlap share a number, and shrinks a declared .limit locals by the
+// slots saved. Returns the slots saved.
+std::size_t coalesce_locals(std::vector<Instruction>& program, SymbolTable& symtab,
+                            OptReport& report);
+
+} // namespace opt
+} // namespace assembler
+
+#endif // ASSEMBLER_Optimizer_hpp
@@ -6,42 +6,65 @@
 #define ASSEMBLER_Parser_hpp
 
 #include "assembler/Token.hpp"
-#include "assembler/IR.hpp"
+#include "assembler/Tokenizer.hpp"
 #include "assembler/SymbolTable.hpp"
 #include "assembler/ConstantPool.hpp"   
+#include "assembler/Interner.hpp"
+#include "assembler/Optimizer.hpp"
 #include <vector>
 #include <string>
 
 class Parser {
 public:
-    Parser(const std::vector<Token>& t);
+    // Tokens are pulled from `src` one at a time; the parser only ever
+    // holds the current token, so memory does not grow with the input.
+    // Identifiers are interned into `names`, which the symbol table and
+    // the instructions' operands refer to; it must outlive the results.
+    Parser(TokenSource& src, assembler::Interner& names);
 
     std::vector<Instruction> parse();
+
+    // Branch relaxation (see Layout.hpp), on by default. When off, every
+    // jump keeps the form it was written in and must reach its target.
+    void set_relax(bool on) { relax = on; }
+
+    // Optimizer passes run between pass 1 and layout (see Optimizer.hpp).
+    void set_optimize(const assembler::OptOptions& o) { opts = o; }
+    const assembler::OptReport& opt_report() const { return optrep; }
     const std::vector<std::string>& errors() const;
 
     const assembler::ConstantPool& get_constpool() const { return constpool; }
     const SymbolTable& symbols() const { return symtab; }
+    const assembler::Interner& names() const { return interner; }
 
 
 private:
-    const std::vector<Token>& toks;
-    size_t idx;
+    TokenSource& src;
+    Token tok;      // one token of lookahead
+    size_t idx;     // tokens consumed so far
 
     std::vector<Instruction> instrs;
     std::vector<std::string> errlist;
 
     SymbolTable symtab; //added for symbol table
     assembler::ConstantPool constpool;
+    assembler::Interner& interner;
+    bool relax = true;
+    assembler::OptOptions opts;
+    assembler::OptReport  optrep;
 
     const Token& cur() const;
     void advance();
     bool accept(TokenType t);
     bool expect(TokenType t);
 
+    SymbolId sym_of(const Token& t);
+
     void parse_line();
     void parse_operands(Instruction &ins);
     void parse_directive();
     void validate_instruction(const Instruction &ins);
+    void check_frame_limits();
 };
 
 #endif // ASSEMBLER_Parser_hpp
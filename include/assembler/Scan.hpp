@@ -0,0 +1,43 @@
+// ============================================================================
+// Scan.hpp - vectorized byte scanning used by the Tokenizer
+// ============================================================================
+#ifndef ASSEMBLER_Scan_hpp
+#define ASSEMBLER_Scan_hpp
+
+#include <cstddef>
+
+namespace assembler {
+namespace scan {
+
+// Instruction set used by the scanners. The best one the CPU supports is
+// picked on first use; set_isa() exists for benchmarking and testing.
+enum class Isa { Scalar, SSE2, AVX2 };
+
+Isa  active_isa();
+bool isa_supported(Isa isa);
+bool set_isa(Isa isa);            // false (and no change) if unsupported
+const char* isa_name(Isa isa);
+
+// Whitespace, as std::isspace in the "C" locale: ' ', '\t', '\n', '\v',
+// '\f', '\r'.
+inline bool is_space(char c) {
+    return c == ' ' || (unsigned char)(c - '\t') <= (unsigned char)('\r' - '\t');
+}
+
+// Result of skipping a whitespace run.
+struct SpaceRun {
+    std::size_t end;           // first non-space position (or n)
+    std::size_t newlines;      // '\n' bytes inside [pos, end)
+    std::size_t last_newline;  // position of the last of them, if any
+};
+
+// Skips whitespace in s[pos, n).
+SpaceRun skip_space(const char* s, std::size_t pos, std::size_t n);
+
+// Position of the first '\n' in s[pos, n), or n if there is none.
+std::size_t find_newline(const char* s, std::size_t pos, std::size_t n);
+
+} // namespace scan
+} // namespace assembler
+
+#endif // ASSEMBLER_Scan_hpp
@@ -0,0 +1,110 @@
+// ============================================================================
+// SmallVector.hpp - vector with inline storage for the first N elements
+// ============================================================================
+#ifndef ASSEMBLER_SmallVector_hpp
+#define ASSEMBLER_SmallVector_hpp
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace assembler {
+
+// Holds up to N elements without touching the heap and spills to a
+// malloc'd array beyond that. Restricted to trivially copyable element
+// types so growth and copies are plain memcpy.
+template <typename T, unsigned N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SmallVector only holds trivially copyable types");
+    static_assert(N > 0, "SmallVector needs inline capacity");
+
+public:
+    SmallVector() = default;
+    SmallVector(const SmallVector& o) { assign(o); }
+    SmallVector(SmallVector&& o) noexcept { steal(o); }
+    SmallVector& operator=(const SmallVector& o) {
+        if (this != &o) { clear(); assign(o); }
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& o) noexcept {
+        if (this != &o) { release(); steal(o); }
+        return *this;
+    }
+    ~SmallVector() { release(); }
+
+    T*       data()       { return cap_ > N ? heap_ : reinterpret_cast<T*>(inline_); }
+    const T* data() const { return cap_ > N ? heap_ : reinterpret_cast<const T*>(inline_); }
+
+    uint32_t size() const { return size_; }
+    bool     empty() const { return size_ == 0; }
+
+    T&       operator[](std::size_t i)       { return data()[i]; }
+    const T& operator[](std::size_t i) const { return data()[i]; }
+    T&       front()       { return data()[0]; }
+    const T& front() const { return data()[0]; }
+    T&       back()        { return data()[size_ - 1]; }
+    const T& back() const  { return data()[size_ - 1]; }
+
+    T*       begin()       { return data(); }
+    T*       end()         { return data() + size_; }
+    const T* begin() const { return data(); }
+    const T* end() const   { return data() + size_; }
+
+    void push_back(const T& v) {
+        if (size_ == cap_) grow(cap_ * 2);
+        data()[size_++] = v;
+    }
+    void pop_back() { --size_; }
+    void clear() { size_ = 0; }
+
+    // Removes element i, shifting the rest down.
+    void erase(std::size_t i) {
+        T* d = data();
+        std::memmove(d + i, d + i + 1, (size_ - i - 1) * sizeof(T));
+        --size_;
+    }
+
+private:
+    void grow(uint32_t cap) {
+        T* p = static_cast<T*>(std::malloc(cap * sizeof(T)));
+        if (!p) throw std::bad_alloc();
+        std::memcpy(p, data(), size_ * sizeof(T));
+        release();
+        heap_ = p;
+        cap_  = cap;
+    }
+    void release() {
+        if (cap_ > N) std::free(heap_);
+        cap_ = N;
+    }
+    void assign(const SmallVector& o) {
+        if (o.size_ > cap_) grow(o.size_);
+        std::memcpy(data(), o.data(), o.size_ * sizeof(T));
+        size_ = o.size_;
+    }
+    void steal(SmallVector& o) {
+        if (o.cap_ > N) {
+            heap_ = o.heap_;
+        } else {
+            std::memcpy(inline_, o.inline_, o.size_ * sizeof(T));
+        }
+        size_ = o.size_;
+        cap_  = o.cap_;
+        o.size_ = 0;
+        o.cap_  = N;
+    }
+
+    union {
+        alignas(T) unsigned char inline_[N * sizeof(T)];
+        T*                       heap_;
+    };
+    uint32_t size_ = 0;
+    uint32_t cap_  = N;
+};
+
+} // namespace assembler
+
+#endif // ASSEMBLER_SmallVector_hpp
@@ -0,0 +1,57 @@
+// ============================================================================
+// Stats.hpp - per-phase timing, counters and heap allocation tracking
+// ============================================================================
+#ifndef ASSEMBLER_Stats_hpp
+#define ASSEMBLER_Stats_hpp
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace assembler {
+namespace stats {
+
+// Everything below is a no-op until enable() is called; the only cost left
+// when disabled is one relaxed load per phase, counter and allocation.
+void enable();
+bool enabled();
+
+struct PhaseReport {
+    std::string name;
+    double   wall_ms     = 0;
+    double   cpu_ms      = 0;   // process CPU time (all threads)
+    uint64_t allocs      = 0;   // operator new calls
+    uint64_t alloc_bytes = 0;   // bytes requested
+    uint64_t peak_bytes  = 0;   // peak live heap above the phase's start
+};
+
+// Times one phase from construction to destruction. Phases may repeat;
+// each occurrence gets its own entry.
+class Phase {
+public:
+    explicit Phase(const char* name);
+    ~Phase();
+    Phase(const Phase&) = delete;
+    Phase& operator=(const Phase&) = delete;
+
+private:
+    const char* name_;
+    bool        active_;
+    double      wall0_, cpu0_;
+    uint64_t    allocs0_, bytes0_;
+    int64_t     live0_;
+};
+
+// Sets (not adds to) a named counter.
+void count(const char* name, uint64_t value);
+
+const std::vector<PhaseReport>& phases();
+
+// {"phases":[...],"counters":{...},"heap":{...}}
+void write_json(std::ostream& out);
+
+} // namespace stats
+} // namespace assembler
+
+#endif // ASSEMBLER_Stats_hpp
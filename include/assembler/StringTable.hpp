@@ -0,0 +1,50 @@
+// ============================================================================
+// StringTable.hpp - the .vm string table: names and string constants
+// ============================================================================
+#ifndef ASSEMBLER_StringTable_hpp
+#define ASSEMBLER_StringTable_hpp
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace assembler {
+
+// One copy of every distinct string, NUL-terminated, where a string that
+// ends another one is stored inside it ("run" lives in "main_run"). The
+// file refers to strings by u32 offset into the table; string constants
+// also carry their length.
+//
+// The table keeps views: the added bytes must outlive it.
+class StringTable {
+public:
+    void add(std::string_view s);
+
+    // Lays the table out. add() must not be called afterwards.
+    void finish();
+
+    // Offset of an added string; valid after finish().
+    uint32_t offset(std::string_view s) const;
+
+    const std::string& data() const { return data_; }
+    uint32_t size_bytes() const { return static_cast<uint32_t>(data_.size()); }
+
+private:
+    // Open addressing over the distinct strings, keeping each one's hash
+    struct Slot {
+        uint32_t id;      // strings_ index + 1, 0 = empty
+        uint32_t hash;
+    };
+    std::size_t find_slot(std::string_view s, uint32_t h) const;
+    void grow();
+
+    std::vector<std::string_view> strings_;  // distinct, first-add order
+    std::vector<Slot>             slots_;
+    std::vector<uint32_t>         offsets_;  // by id
+    std::string                   data_;
+};
+
+} // namespace assembler
+
+#endif // ASSEMBLER_StringTable_hpp
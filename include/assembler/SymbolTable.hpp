@@ -9,162 +9,220 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "assembler/Interner.hpp"
+
+using assembler::SymbolId;
+using assembler::NO_SYMBOL;
 
 enum class Section { NONE, DATA, TEXT };
 
+// Instruction index that is not (yet) known.
+constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+// Names below are ids in the assembly's Interner (see names()).
+
 struct LabelInfo {
     uint32_t address;     // absolute byte address = base + LC at definition time
+    uint32_t instr_index; // first instruction after the label (== count at the end)
     int line;             
     int col;
+    bool defined = false; // labels() is indexed by SymbolId; most ids are not labels
 };
 
 struct ConstantInfo {
-    std::string name;
+    SymbolId    name;
     int32_t     value;    // simple int constants 
 };
 
 struct FieldInfo {
-    std::string owner_class; 
-    std::string name;        
-    std::string descriptor; 
+    SymbolId    owner_class; 
+    SymbolId    name;        
+    SymbolId    descriptor; 
     uint32_t    pool_index; 
 };
 
 struct MethodInfo {
-    std::string name;         // "main"
+    SymbolId    name;         // "main"
     std::string signature;    // e.g., "(I)V" or "([Ljava/lang/String;)V"
     uint32_t    address;      // absolute byte address where method code starts (base+offset)
     uint32_t    size;         // size of the method in bytes
-    uint32_t    stack_limit;  // from .limit stack
-    uint32_t    locals_limit; // from .limit locals
+    uint32_t    stack_limit;  // from .limit stack, else computed (Analysis.hpp)
+    bool        has_stack_limit; // .limit stack was given
+    uint32_t    locals_limit; // from .limit locals, else computed
+    bool        has_locals_limit; // .limit locals was given
      uint32_t    pool_index; 
+    uint32_t    first_instr;  // instruction range [first_instr, end_instr), so layout
+    uint32_t    end_instr;    // can move the method; NO_INDEX for a pinned address
 
 
     MethodInfo()
-        : address(0), stack_limit(0), locals_limit(0) {}
+        : name(NO_SYMBOL), address(0), stack_limit(0), has_stack_limit(false), locals_limit(0),
+          has_locals_limit(false),
+          first_instr(NO_INDEX), end_instr(NO_INDEX) {}
 };
 
 struct ClassInfo {
-    std::string name;          // "Example"
-    std::string super_name;    // "java/lang/Object"
+    SymbolId    name;          // "Example"
+    SymbolId    super_name;    // "java/lang/Object" (NO_SYMBOL => none)
     std::vector<FieldInfo>  fields;
-    std::vector<std::string> methods; // store method names (or qualified keys) available in this class
+    std::vector<SymbolId>   methods; // qualified method keys available in this class
     uint32_t    pool_index;    // constant-pool index if you later add a CP (UINT32_MAX => unknown)
 
-    ClassInfo() : pool_index(UINT32_MAX) {}
+    ClassInfo() : name(NO_SYMBOL), super_name(NO_SYMBOL), pool_index(UINT32_MAX) {}
 };
 
-struct PendingRef {
-    // what to patch after pass 1
+enum class FixupKind : uint8_t {
+    Label,      // branch target: a label
+    Method,     // CALL / INVOKE* target: a method key
+};
+
+// A label or method reference recorded in pass 1. Once layout has fixed
+// every address, pass 2 fills in `value` with what the operand slot must
+// hold; the encoder then writes it there.
+struct Fixup {
     std::size_t instr_index;    // which instruction in the IR
     std::size_t operand_index;  // which operand of that instruction
-    std::string label;          // label text
+    SymbolId    target;         // label name or method key
+    FixupKind   kind;
+    uint8_t     width;          // encoded size of the slot in bytes
     int line;
     int col;
 
     // for debug: where in code the ref appears (byte LC when encountered)
     uint32_t from_code_offset;
+
+    bool     resolved = false;
+    uint32_t value = 0;         // target address (or displacement) once resolved
 };
 
 // ---------- SymbolTable ----------
 
 class SymbolTable {
 public:
-    explicit SymbolTable(uint32_t base_addr = 0)
-        : base_address_(base_addr), lc_bytes_(0),
-          current_class_(""), current_method_key_("") {}
+    // Keys are ids interned in `names`, which must outlive the table.
+    explicit SymbolTable(assembler::Interner& names, uint32_t base_addr = 0)
+        : names_(&names), base_address_(base_addr), lc_bytes_(0),
+          current_class_(NO_SYMBOL), current_method_key_(NO_SYMBOL) {}
+
+    const assembler::Interner& names() const { return *names_; }
 
     // ----- Base + LC management -----
     void set_base(uint32_t base) { base_address_ = base; }
     uint32_t base() const { return base_address_; }
-    std::string get_current_class() const {
+    SymbolId get_current_class() const {
         return current_class_;
     }
-    void reset_lc() { lc_bytes_ = 0; }
+    void reset_lc() { lc_bytes_ = 0; instr_count_ = 0; }
     uint32_t lc() const { return lc_bytes_; }
-    void advance_lc(uint32_t bytes) { lc_bytes_ += bytes; }
+    // Called once per instruction, so the table also knows how many
+    // instructions precede each label and method.
+    void advance_lc(uint32_t bytes) { lc_bytes_ += bytes; ++instr_count_; }
+
+    // Moves every label, method and fixup to the layout in `offsets`: the
+    // code offset of each instruction, plus the total size at the end.
+    void relocate(const std::vector<uint32_t>& offsets);
+
+    // Follows instructions being removed: `new_index[i]` is the number of
+    // kept instructions before old instruction i (size: old count + 1), so
+    // instruction i was dropped iff new_index[i] == new_index[i + 1]. Labels
+    // and methods keep their position; fixups of dropped instructions go.
+    void renumber(const std::vector<uint32_t>& new_index);
 
     // ----- Labels -----
     // Define label at current absolute addr = base + LC.
     // Returns false if duplicate; on success fills out LabelInfo.
-    bool define_label(const std::string& name, int line, int col);
+    bool define_label(SymbolId name, int line, int col);
 
     // Lookup: returns {found, info}
-    std::pair<bool, LabelInfo> get_label(const std::string& name) const;
-
-    // ----- Pending control-flow references -----
-    void add_label_reference(std::size_t instr_index,
-                             std::size_t operand_index,
-                             const std::string& label,
-                             int line, int col);
-
-    const std::vector<PendingRef>& pending_refs() const { return pending_refs_; }
+    std::pair<bool, LabelInfo> get_label(SymbolId name) const;
+
+    // ----- Control-flow fixups -----
+    void add_fixup(std::size_t instr_index,
+                   std::size_t operand_index,
+                   SymbolId target, uint8_t width,
+                   int line, int col,
+                   FixupKind kind = FixupKind::Label);
+
+    const std::vector<Fixup>& fixups() const { return fixups_; }
+    void resolve_fixup(std::size_t i, uint32_t value, uint8_t width) {
+        fixups_[i].resolved = true;
+        fixups_[i].value = value;
+        fixups_[i].width = width;
+    }
+    // Points fixup `i` at another target (jump threading, label merging).
+    void retarget_fixup(std::size_t i, SymbolId target) { fixups_[i].target = target; }
 
     // ----- Constants (.const) -----
-    bool define_constant(const std::string& name, int32_t value); // false if duplicate
-    std::pair<bool, ConstantInfo> get_constant(const std::string& name) const;
+    bool define_constant(SymbolId name, int32_t value); // false if duplicate
+    std::pair<bool, ConstantInfo> get_constant(SymbolId name) const;
 
     // ----- Classes (.class / .super) -----
     // Begin a class scope (must end with end_class)
-    bool begin_class(const std::string& class_name); // false if already declared
+    bool begin_class(SymbolId class_name); // false if already declared
     // Set super; returns false if no active class
-    bool set_super(const std::string& super_name);
+    bool set_super(SymbolId super_name);
     // Add a field to current or specific class
-    bool add_field(const std::string& owner_class,
-                   const std::string& field_name,
-                   const std::string& descriptor,
+    bool add_field(SymbolId owner_class,
+                   SymbolId field_name,
+                   SymbolId descriptor,
                    uint32_t pool_index = UINT32_MAX);
     // End active class
     bool end_class();
 
     // Lookup class
-    std::pair<bool, ClassInfo> get_class(const std::string& class_name) const;
+    std::pair<bool, ClassInfo> get_class(SymbolId class_name) const;
 
     // ----- Methods (.method / .limit / .entry / .end) -----
     // Begin method scope under the current class (or standalone if class empty)
-    // method_key convention: "ClassName.methodName:signature" if class present; else "methodName:signature"
-    bool begin_method(const std::string& method_name,
+    // method_key convention: "ClassName.methodName" if class present; else "methodName"
+    bool begin_method(SymbolId method_name,
                       const std::string& signature);
 
     // Set limits/entry on the active method
     bool set_method_stack_limit(uint32_t limit);
     bool set_method_locals_limit(uint32_t limit);
 
-    // Set starting address of active method (usually current base+LC when first instruction emitted)
+    // Set the limits of any method (computed ones; the directives go
+    // through set_method_*_limit)
+    bool set_stack_limit(SymbolId method_key, uint32_t limit);
+    bool set_locals_limit(SymbolId method_key, uint32_t limit);
+
+    // Pin the starting address of the active method; layout no longer moves it
     bool set_method_address(uint32_t address);
 
     // End active method scope
     bool end_method();
 
     // Direct define (for non-scoped usage)
-    bool define_method(const std::string& class_name,
-                       const std::string& method_name,
+    bool define_method(SymbolId class_name,
+                       SymbolId method_name,
                        const std::string& signature,
                        uint32_t address,
                        uint32_t stack_limit,
                        uint32_t locals_limit);
 
     // Lookup by key (same format as produced by make_method_key)
-    std::pair<bool, MethodInfo> get_method(const std::string& method_key) const;
-    std::pair<bool, FieldInfo> get_field(const std::string& field_key) const;
+    std::pair<bool, MethodInfo> get_method(SymbolId method_key) const;
+    std::pair<bool, FieldInfo> get_field(SymbolId field_key) const;
 
     // ----- Diagnostics / Accessors -----
-    const std::unordered_map<std::string, LabelInfo>&   labels()   const { return labels_; }
-    const std::unordered_map<std::string, ConstantInfo>& constants() const { return constants_; }
-    const std::unordered_map<std::string, FieldInfo>&    fields()   const { return fields_; }
-    const std::unordered_map<std::string, MethodInfo>&   methods()  const { return methods_; }
-    const std::unordered_map<std::string, ClassInfo>&    classes()  const { return classes_; }
-
-    // helpers to build stable keys
-    static std::string make_field_key(const std::string& owner,
-                                      const std::string& name);
-    static std::string make_method_key(const std::string& owner,
-                                       const std::string& name,
-                                       const std::string& sig);
-
-    // Current scopes (empty string if none)
-    const std::string& current_class() const { return current_class_; }
-    const std::string& current_method_key() const { return current_method_key_; }
+    const std::vector<LabelInfo>&                     labels()   const { return labels_; }
+    std::size_t label_count() const { return label_count_; }
+    const std::unordered_map<SymbolId, ConstantInfo>& constants() const { return constants_; }
+    const std::unordered_map<SymbolId, FieldInfo>&    fields()   const { return fields_; }
+    const std::unordered_map<SymbolId, MethodInfo>&   methods()  const { return methods_; }
+    const std::unordered_map<SymbolId, ClassInfo>&    classes()  const { return classes_; }
+
+    // helpers to build stable keys: the interned "Owner.name" (or just
+    // "name" when there is no owner), so that a qualified operand such as
+    // "MyClass.myField" is already its own key.
+    SymbolId make_field_key(SymbolId owner, SymbolId name);
+    SymbolId make_method_key(SymbolId owner, SymbolId name,
+                             const std::string& sig);
+
+    // Current scopes (NO_SYMBOL if none)
+    SymbolId current_class() const { return current_class_; }
+    SymbolId current_method_key() const { return current_method_key_; }
 
         // ----- Sections (.data / .text) -----
         void begin_data() { current_section_ = Section::DATA; }
@@ -172,36 +230,42 @@ public:
         Section current_section() const { return current_section_; }
 
         // data symbol management
-        bool define_data_symbol(const std::string& name, const std::vector<int32_t>& values);
-        std::pair<bool, std::vector<int32_t>> get_data_symbol(const std::string& name) const;
+        bool define_data_symbol(SymbolId name, const std::vector<int32_t>& values);
+        std::pair<bool, std::vector<int32_t>> get_data_symbol(SymbolId name) const;
 
 
 private:
+    SymbolId qualified(SymbolId owner, SymbolId name);
+    ClassInfo& class_entry(SymbolId class_name);
+
+    assembler::Interner* names_;
     uint32_t base_address_;
     uint32_t lc_bytes_;
+    uint32_t instr_count_ = 0;
 
-    std::unordered_map<std::string, LabelInfo> labels_;
-    std::vector<PendingRef> pending_refs_;
+    std::vector<LabelInfo> labels_;     // indexed by SymbolId
+    std::size_t label_count_ = 0;
+    std::vector<Fixup> fixups_;         // in instruction order
 
-    std::unordered_map<std::string, ConstantInfo> constants_;
+    std::unordered_map<SymbolId, ConstantInfo> constants_;
 
     // keys:
     //  - field key: "OwnerClass.fieldName"
-    //  - method key: "OwnerClass.methodName:signature" or "methodName:signature" if no class
-    std::unordered_map<std::string, FieldInfo>  fields_;
-    std::unordered_map<std::string, MethodInfo> methods_;
-    std::unordered_map<std::string, ClassInfo>  classes_;
+    //  - method key: "OwnerClass.methodName" or "methodName" if no class
+    std::unordered_map<SymbolId, FieldInfo>  fields_;
+    std::unordered_map<SymbolId, MethodInfo> methods_;
+    std::unordered_map<SymbolId, ClassInfo>  classes_;
 
     // active scopes
-    std::string current_class_;
-    std::string current_method_key_;
+    SymbolId current_class_;
+    SymbolId current_method_key_;
 
     // active section tracking
 Section current_section_ = Section::NONE;
 
 // data symbols (for .data section)
 // name -> vector of values (since a label may refer to an array of constants)
-std::unordered_map<std::string, std::vector<int32_t>> data_symbols_;
+std::unordered_map<SymbolId, std::vector<int32_t>> data_symbols_;
 
 };
 
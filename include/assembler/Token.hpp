@@ -5,7 +5,9 @@
 #define ASSEMBLER_Token_hpp
 
 
-#include <string>
+#include <string_view>
+#include "assembler/Keywords.hpp"
+#include "assembler/Interner.hpp"
 
 
 enum class TokenType {
@@ -32,11 +34,17 @@ inline const char* tokenTypeToString(TokenType type) {
         default:                    return "UNKNOWN";
     }
 }
+// `value` is a view into the source buffer the Tokenizer was built over (or
+// into static storage for canonical mnemonics / punctuation), so the buffer
+// must outlive every token taken from it.
 struct Token {
 TokenType type;
-std::string value;
+std::string_view value;
 int line;
 int col;
+OpCode op = OpCode::INVALID;          // resolved opcode of a MNEMONIC
+Directive dir = Directive::NONE;      // resolved id of a DIRECTIVE
+assembler::SymbolId sym = assembler::NO_SYMBOL;  // interned IDENT / LABEL_DEF name
 };
 
 
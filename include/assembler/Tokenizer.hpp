@@ -5,24 +5,74 @@
 #define ASSEMBLER_Tokenizer_hpp
 
 #include "Token.hpp"
+#include "Input.hpp"
 #include <vector>
-#include <string>
+#include <string_view>
 
-class Tokenizer {
+// Anything the Parser can pull tokens from, one at a time. After the last
+// real token, next() keeps returning END_OF_FILE.
+class TokenSource {
 public:
-    explicit Tokenizer(const std::string &src);
+    virtual ~TokenSource() = default;
+    virtual Token next() = 0;
+};
+
+// Replays an already tokenized vector.
+class VectorTokenSource : public TokenSource {
+public:
+    explicit VectorTokenSource(const std::vector<Token>& toks) : toks(toks) {}
+    Token next() override;
+
+private:
+    const std::vector<Token>& toks;
+    size_t idx = 0;
+};
+
+class Tokenizer : public TokenSource {
+public:
+    // Tokens hold views into `src`; the caller keeps the buffer alive.
+    // With `names`, IDENT and LABEL_DEF tokens also carry their interned id.
+    explicit Tokenizer(std::string_view src, assembler::Interner* names = nullptr);
+
+    // Streaming mode: bytes are pulled from `in` as they are needed. A
+    // token's views stay valid only until the following call to next().
+    explicit Tokenizer(assembler::StreamBuffer& in, assembler::Interner* names = nullptr);
+
+    Token next() override;
     std::vector<Token> tokenize();
 
+    // Tokens handed out so far, not counting END_OF_FILE
+    size_t count() const { return made; }
+
+    // Splits `src` at newlines into up to `jobs` chunks of at least
+    // `min_chunk` bytes, tokenizes them on worker threads and stitches the
+    // results back together with corrected line numbers. The result is
+    // identical to Tokenizer(src, names).tokenize(). Names are interned on
+    // the calling thread after the workers finish.
+    static std::vector<Token> tokenize_parallel(std::string_view src, unsigned jobs,
+                                                assembler::Interner* names = nullptr,
+                                                size_t min_chunk = 256 * 1024);
+
 private:
-    std::string src;
+    std::string_view src;          // current window
+    assembler::StreamBuffer* in;   // null when tokenizing a whole buffer
+    assembler::Interner* names;    // null: leave Token::sym unset
+    size_t base;                   // absolute offset of src[0]
     size_t pos;
-    int line, col;
+    size_t tok_start;              // start of the token being scanned
+    int line;
+    size_t line_start;             // absolute offset of the current line
+    size_t made = 0;
 
-    bool eof() const;
-    char peek() const;
+    bool fill();
+    bool eof();
+    char peek();
+    char peek_at(size_t k);
     char get();
+    int col() const { return (int)(base + pos - line_start) + 1; }
     void skip_space();
-    Token make(TokenType t, const std::string &v, int l, int c) const;
+    void skip_to_newline();
+    Token make(TokenType t, std::string_view v, int l, int c);
 };
 
 #endif // ASSEMBLER_Tokenizer_hpp
\ No newline at end of file
@@ -0,0 +1,67 @@
+// ============================================================================
+// VMFormat.hpp - layout of the .vm container, shared by writer and loader
+// ============================================================================
+#ifndef ASSEMBLER_VMFormat_hpp
+#define ASSEMBLER_VMFormat_hpp
+
+#include <cstdint>
+
+namespace assembler {
+namespace vm {
+
+// A .vm file is a fixed header, a section directory and the sections. Every
+// integer is little-endian, whatever the host, and every section starts on
+// an ALIGN boundary, so a loader can map the file read-only and use it in
+// place:
+//
+//   header     HEADER_SIZE bytes (below)
+//   directory  section_count entries of DIR_ENTRY_SIZE bytes
+//   sections   in directory order, each at a multiple of ALIGN
+//
+// Header:
+//   u32 magic, u32 version, u32 header_size, u32 align, u32 entry_point,
+//   u32 section_count, u32 directory_offset, u32 file_size, zero padding
+//
+// Directory entry:
+//   u32 kind, u32 offset, u32 size, u32 count (records, or pool entries)
+
+constexpr uint32_t MAGIC          = 0x01004D56;   // "VM\1"
+constexpr uint32_t VERSION        = 4;
+constexpr uint32_t HEADER_SIZE    = 64;
+constexpr uint32_t DIR_ENTRY_SIZE = 16;
+constexpr uint32_t ALIGN          = 64;           // a cache line
+
+enum class Section : uint32_t {
+    POOL      = 1,   // ConstantPool::emit: count, offset table, entries
+    CODE      = 2,   // bytecode; method addresses are offsets into it
+    CLASSES   = 3,   // ClassRecord[count], superclasses before subclasses
+    FIELDS    = 4,   // FieldRecord[count], grouped by class
+    METHODS   = 5,   // MethodRecord[count], grouped by class
+    STRINGS   = 6,   // StringTable: NUL-terminated, suffix-shared
+    FUNCTIONS = 7,   // MethodRecord[count]: methods outside any class, by name
+};
+constexpr uint32_t SECTION_KINDS = 7;
+
+// Fixed-size records, all fields u32 (names are string-table offsets):
+//   class:  name, super (index or 0xFFFFFFFF), first_field, field_count,
+//           first_method, method_count
+//   field:  name, pool_index
+//   method: name, address, size, max_stack, max_locals
+constexpr uint32_t CLASS_RECORD_SIZE  = 24;
+constexpr uint32_t FIELD_RECORD_SIZE  = 8;
+constexpr uint32_t METHOD_RECORD_SIZE = 20;
+constexpr uint32_t NO_CLASS = UINT32_MAX;
+
+inline uint8_t* put_u32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; p[2] = (v >> 16) & 0xFF; p[3] = (v >> 24) & 0xFF;
+    return p + 4;
+}
+
+inline uint32_t get_u32(const uint8_t* p) {
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+} // namespace vm
+} // namespace assembler
+
+#endif // ASSEMBLER_VMFormat_hpp
@@ -0,0 +1,113 @@
+// ============================================================================
+// VMLoader.hpp - reference loader: maps a .vm file and reads it in place
+// ============================================================================
+#ifndef ASSEMBLER_VMLoader_hpp
+#define ASSEMBLER_VMLoader_hpp
+
+#include "VMFormat.hpp"
+#include "ConstantPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace assembler {
+
+struct PoolConstant {
+    ConstTag         tag;
+    uint32_t         bits;   // INT: the value, FLOAT: IEEE-754 bits
+    std::string_view str;    // STRING: the bytes, inside the mapping
+};
+
+struct ClassRecord {
+    uint32_t name;           // string-table offset
+    uint32_t super;          // class index, or vm::NO_CLASS
+    uint32_t first_field, field_count;
+    uint32_t first_method, method_count;
+};
+
+struct FieldRecord {
+    uint32_t name;
+    uint32_t pool_index;
+};
+
+struct MethodRecord {
+    uint32_t name;
+    uint32_t address;        // offset into code()
+    uint32_t size;
+    uint32_t max_stack;
+    uint32_t max_locals;
+};
+
+// A .vm file mapped read-only (read into memory on Windows). Nothing is
+// copied or decoded up front: open() checks the header and the section
+// directory, and every accessor reads straight from the mapping, so opening
+// costs the same however large the program is. Owns the mapping.
+class VMImage {
+public:
+    VMImage() = default;
+    ~VMImage();
+    VMImage(VMImage&& other) noexcept;
+    VMImage& operator=(VMImage&& other) noexcept;
+    VMImage(const VMImage&) = delete;
+    VMImage& operator=(const VMImage&) = delete;
+
+    // Maps `path` and checks the header and that every section lies, aligned,
+    // inside the file. On failure returns false and says why in `error`.
+    bool open(const std::string& path, std::string& error);
+
+    // Checks every pool entry, record and name reference; linear in the
+    // file, which open() is not.
+    bool verify(std::string& error) const;
+
+    uint32_t       entry_point() const { return entry_; }
+    const uint8_t* code() const { return section(vm::Section::CODE).data; }
+    uint32_t       code_size() const { return section(vm::Section::CODE).size; }
+
+    // Pool indices start at 1. False if `index` is out of range or its
+    // entry is malformed.
+    uint32_t pool_count() const { return section(vm::Section::POOL).count; }
+    bool     constant(uint32_t index, PoolConstant& out) const;
+
+    // Indices must be below the matching count.
+    uint32_t     class_count() const { return section(vm::Section::CLASSES).count; }
+    uint32_t     field_count() const { return section(vm::Section::FIELDS).count; }
+    uint32_t     method_count() const { return section(vm::Section::METHODS).count; }
+    uint32_t     function_count() const { return section(vm::Section::FUNCTIONS).count; }
+    ClassRecord  class_at(uint32_t i) const;
+    FieldRecord  field_at(uint32_t i) const;
+    MethodRecord method_at(uint32_t i) const;
+    MethodRecord function_at(uint32_t i) const;
+
+    // Binary search of the functions (methods outside any class) by name.
+    bool find_function(std::string_view name, MethodRecord& out) const;
+
+    // The NUL-terminated string at `offset` in the string table; empty if
+    // `offset` is outside it.
+    std::string_view string_at(uint32_t offset) const;
+
+private:
+    struct Span {
+        const uint8_t* data = nullptr;
+        uint32_t       size = 0;
+        uint32_t       count = 0;
+    };
+    const Span& section(vm::Section kind) const {
+        return sections_[static_cast<uint32_t>(kind)];
+    }
+    bool check(std::string& error);
+    static MethodRecord method_record(const uint8_t* r);
+    void release();
+
+    const uint8_t*       data_ = nullptr;
+    std::size_t          size_ = 0;
+    bool                 mapped_ = false;
+    std::vector<uint8_t> copy_;           // the file, when it is not mapped
+    uint32_t             entry_ = 0;
+    Span                 sections_[vm::SECTION_KINDS + 1];
+};
+
+} // namespace assembler
+
+#endif // ASSEMBLER_VMLoader_hpp
@@ -0,0 +1,232 @@
+// ============================================================================
+// Analysis.cpp - per-method control-flow graph, stack depth and locals
+// ============================================================================
+#include "assembler/Analysis.hpp"
+#include "assembler/Opcodes.hpp"
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+
+namespace assembler {
+
+namespace {
+
+bool is_branch(OpCode op) {
+    OperandType t = opcode_info(op).operand;
+    return t == OperandType::Branch || t == OperandType::RelBranch;
+}
+
+bool is_goto(OpCode op) {
+    return op == OpCode::JMP || op == OpCode::JMP_S || op == OpCode::JMP_W;
+}
+
+// The fixup of kind `kind` on instruction `i`, or nullptr. Fixups are
+// recorded in instruction order.
+const Fixup* fixup_of(const SymbolTable& symtab, std::size_t i, FixupKind kind) {
+    const std::vector<Fixup>& fx = symtab.fixups();
+    auto it = std::lower_bound(fx.begin(), fx.end(), i,
+                               [](const Fixup& f, std::size_t k) { return f.instr_index < k; });
+    for (; it != fx.end() && it->instr_index == i; ++it)
+        if (it->kind == kind) return &*it;
+    return nullptr;
+}
+
+// Target instruction of the branch at `i`, or NO_INDEX if it is not a
+// defined label.
+uint32_t branch_target(const SymbolTable& symtab, std::size_t i) {
+    const Fixup* f = fixup_of(symtab, i, FixupKind::Label);
+    if (!f) return NO_INDEX;
+    auto label = symtab.get_label(f->target);
+    return label.first ? label.second.instr_index : NO_INDEX;
+}
+
+// What a call to a method does to the caller's stack.
+struct CallEffect {
+    uint32_t args = 0;
+    uint32_t returns = 0;
+};
+
+StackReport stack_depth(const std::vector<Instruction>& program, const SymbolTable& symtab,
+                        SymbolId key, const MethodInfo& mi,
+                        const std::unordered_map<SymbolId, CallEffect>& effects) {
+    StackReport rep;
+    rep.method = key;
+    MethodCfg cfg = build_cfg(program, symtab, mi);
+    if (cfg.blocks.empty()) return rep;
+    // A branch out of the method or to an unknown target hides part of
+    // the paths: no depth computed here would be the true maximum.
+    if (!cfg.complete) {
+        rep.known = false;
+        return rep;
+    }
+
+    std::vector<int64_t> depth_in(cfg.blocks.size(), -1);
+    std::vector<uint32_t> work{0};
+    depth_in[0] = 0;
+    bool returned = false;
+
+    auto problem = [&](const Instruction& ins, const std::string& what) {
+        std::ostringstream os;
+        os << what << " at line " << ins.src_line;
+        rep.problems.push_back(os.str());
+    };
+
+    while (!work.empty()) {
+        uint32_t b = work.back();
+        work.pop_back();
+        const BasicBlock& bb = cfg.blocks[b];
+        int64_t d = depth_in[b];
+
+        for (uint32_t i = bb.first; i < bb.end; ++i) {
+            const Instruction& ins = program[i];
+            const OpcodeInfo& info = opcode_info(ins.op);
+            int64_t pops = info.pops, pushes = info.pushes;
+            if (ins.op == OpCode::RET) {
+                if (returned && rep.returns != d) {
+                    std::ostringstream os;
+                    os << "RET leaves " << d << " values, another RET leaves " << rep.returns;
+                    problem(ins, os.str());
+                }
+                returned = true;
+                rep.returns = static_cast<uint32_t>(d);
+                pops = d;
+            } else if (info.operand == OperandType::Method) {
+                const Fixup* f = fixup_of(symtab, i, FixupKind::Method);
+                auto it = f ? effects.find(f->target) : effects.end();
+                if (it == effects.end()) {
+                    rep.known = false;
+                    pops = pushes = 0;
+                } else {
+                    pops = it->second.args + (ins.op == OpCode::CALL ? 0 : 1);  // receiver
+                    pushes = it->second.returns;
+                }
+            }
+            if (d < pops) {
+                std::ostringstream os;
+                os << "stack underflow: " << info.mnemonic << " pops " << pops << " of " << d;
+                problem(ins, os.str());
+                d = pops;
+            }
+            d += pushes - pops;
+            rep.max_depth = std::max<uint32_t>(rep.max_depth, static_cast<uint32_t>(d));
+        }
+
+        for (uint32_t s : bb.succ) {
+            if (s == NO_BLOCK) continue;
+            if (depth_in[s] < 0) {
+                depth_in[s] = d;
+                work.push_back(s);
+            } else if (depth_in[s] != d) {
+                std::ostringstream os;
+                os << "stack depth is " << depth_in[s] << " on one path and " << d
+                   << " on another";
+                problem(program[cfg.blocks[s].first], os.str());
+            }
+        }
+    }
+    return rep;
+}
+
+} // namespace
+
+int64_t local_slot(const Instruction& ins) {
+    if (opcode_info(ins.op).operand != OperandType::Local || ins.operands.empty()) return -1;
+    const Operand& op = ins.operands[0];
+    if (op.kind != Operand::Kind::Immediate || op.imm < 0) return -2;
+    return op.imm;
+}
+
+uint32_t locals_used(const std::vector<Instruction>& program, const MethodInfo& method) {
+    uint32_t used = 0;
+    for (uint32_t i = method.first_instr; i < method.end_instr && i < program.size(); ++i) {
+        int64_t slot = local_slot(program[i]);
+        if (slot == -2) return NO_INDEX;
+        if (slot >= 0) used = std::max<uint32_t>(used, static_cast<uint32_t>(slot) + 1);
+    }
+    return used;
+}
+
+MethodCfg build_cfg(const std::vector<Instruction>& program, const SymbolTable& symtab,
+                    const MethodInfo& method) {
+    MethodCfg cfg;
+    uint32_t first = method.first_instr;
+    uint32_t end = std::min<uint32_t>(method.end_instr, static_cast<uint32_t>(program.size()));
+    if (first == NO_INDEX || first >= end) return cfg;
+
+    // Leaders: the entry, every branch target and whatever follows a branch
+    // or a RET.
+    std::vector<uint8_t> leader(end - first + 1, 0);
+    std::vector<uint32_t> target(end - first, NO_INDEX);
+    leader[0] = 1;
+    for (uint32_t i = first; i < end; ++i) {
+        OpCode op = program[i].op;
+        if (is_branch(op)) {
+            uint32_t t = branch_target(symtab, i);
+            if (t < first || t >= end) {
+                cfg.complete = false;
+            } else {
+                target[i - first] = t;
+                leader[t - first] = 1;
+            }
+        }
+        if (is_branch(op) || op == OpCode::RET) leader[i + 1 - first] = 1;
+    }
+
+    cfg.block_of.assign(end - first, NO_BLOCK);
+    for (uint32_t i = first; i < end; ++i) {
+        if (leader[i - first]) cfg.blocks.push_back(BasicBlock{i, i});
+        cfg.blocks.back().end = i + 1;
+        cfg.block_of[i - first] = static_cast<uint32_t>(cfg.blocks.size() - 1);
+    }
+    for (BasicBlock& bb : cfg.blocks) {
+        uint32_t last = bb.end - 1;
+        OpCode op = program[last].op;
+        if (!is_goto(op) && op != OpCode::RET && bb.end < end)
+            bb.succ[0] = cfg.block_of[bb.end - first];
+        if (target[last - first] != NO_INDEX)
+            bb.succ[1] = cfg.block_of[target[last - first] - first];
+    }
+    return cfg;
+}
+
+std::vector<StackReport> analyze_stack(const std::vector<Instruction>& program,
+                                       const SymbolTable& symtab) {
+    std::vector<std::pair<uint32_t, SymbolId>> order;
+    std::unordered_map<SymbolId, CallEffect> effects;
+    for (const auto& kv : symtab.methods()) {
+        const MethodInfo& mi = kv.second;
+        // A method pinned to an address has no instruction range, so it
+        // is not analyzed and calls to it stay unknown.
+        if (mi.first_instr == NO_INDEX || mi.end_instr == NO_INDEX) continue;
+        CallEffect& e = effects[kv.first];
+        order.emplace_back(mi.first_instr, kv.first);
+        for (uint32_t i = mi.first_instr; i < mi.end_instr && i < program.size(); ++i) {
+            const Instruction& ins = program[i];
+            if (ins.op == OpCode::LOAD_ARG && !ins.operands.empty() &&
+                ins.operands[0].kind == Operand::Kind::Immediate && ins.operands[0].imm >= 0)
+                e.args = std::max<uint32_t>(e.args, ins.operands[0].imm + 1);
+        }
+    }
+    std::sort(order.begin(), order.end());
+
+    // What a method returns is what its RET leaves, which can depend on its
+    // own calls: repeat until no method's result changes.
+    std::vector<StackReport> reports;
+    for (int round = 0; round < 8; ++round) {
+        reports.clear();
+        bool changed = false;
+        for (const auto& o : order) {
+            const MethodInfo& mi = symtab.methods().at(o.second);
+            reports.push_back(stack_depth(program, symtab, o.second, mi, effects));
+            CallEffect& e = effects[o.second];
+            if (e.returns != reports.back().returns) {
+                e.returns = reports.back().returns;
+                changed = true;
+            }
+        }
+        if (!changed) break;
+    }
+    return reports;
+}
+
+} // namespace assembler
@@ -3,93 +3,158 @@
 // ============================================================================
 
 #include "assembler/ConstantPool.hpp"
-#include <sstream>
+#include "assembler/StringTable.hpp"
+#include "assembler/VMFormat.hpp"
 #include <cstring>
 #include <iostream>
-#include <iomanip>
 
 using namespace assembler;
 
-// --- Helper to build unique keys for deduplication ---
-static std::string make_key(ConstTag tag, const std::string &val) {
-    return std::to_string(static_cast<int>(tag)) + "|" + val;
+// --- Deduplication: open addressing over (tag, raw bits) ---
+
+uint64_t ConstantPool::hash(const Key& k) {
+    uint64_t h;
+    if (k.tag == ConstTag::STRING) {
+        h = 14695981039346656037ull;               // FNV-1a over the bytes
+        for (unsigned char c : k.str) h = (h ^ c) * 1099511628211ull;
+    } else {
+        h = k.bits;
+    }
+    h ^= static_cast<uint64_t>(k.tag) << 56;
+    // finalizer from splitmix64, so small ints spread over the table
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
 }
 
-// --- Primitive constants ---
-int ConstantPool::add_int(int32_t v) {
-    std::string key = make_key(ConstTag::INT, std::to_string(v));
-    auto it = lookup_.find(key);
-    if (it != lookup_.end()) return it->second;
+bool ConstantPool::same(const ConstEntry& e, const Key& k) const {
+    if (e.tag != k.tag) return false;
+    if (k.tag == ConstTag::STRING) return string_value(e) == k.str;
+    return e.bits == k.bits;
+}
+
+// Slots are indexed by the high hash bits, which the slot keeps, so the
+// table grows without rehashing any constant.
+static inline std::size_t home(uint32_t h, std::size_t size) {
+    return (static_cast<uint64_t>(h) * size) >> 32;
+}
+
+void ConstantPool::grow() {
+    std::vector<Slot> slots(slots_.empty() ? 64 : slots_.size() * 2, Slot{0, 0});
+    std::size_t mask = slots.size() - 1;
+    for (const Slot& s : slots_) {
+        if (!s.pos) continue;
+        std::size_t i = home(s.hash, slots.size());
+        while (slots[i].pos) i = (i + 1) & mask;
+        slots[i] = s;
+    }
+    slots_.swap(slots);
+}
+
+int ConstantPool::add(const Key& k) {
+    if ((pool_.size() + 1) * 2 > slots_.size()) grow();   // load <= 1/2
+    std::size_t mask = slots_.size() - 1;
+    uint32_t h = static_cast<uint32_t>(hash(k) >> 32);
+    std::size_t i = home(h, slots_.size());
+    for (; slots_[i].pos; i = (i + 1) & mask) {
+        if (slots_[i].hash != h) continue;
+        const ConstEntry& e = pool_[slots_[i].pos - 1];
+        if (same(e, k)) return static_cast<int>(e.index);
+    }
 
-    ConstEntry e{ConstTag::INT, next_index_++, std::to_string(v)};
+    ConstEntry e{k.tag, static_cast<uint32_t>(pool_.size() + 1), k.bits, 0};
+    if (k.tag == ConstTag::STRING) {
+        e.bits = static_cast<uint32_t>(blob_.size());
+        e.length = static_cast<uint32_t>(k.str.size());
+        blob_.append(k.str.data(), k.str.size());
+        ++string_count_;
+    }
     pool_.push_back(e);
-    lookup_[key] = e.index;
-    return e.index;
+    slots_[i] = Slot{static_cast<uint32_t>(pool_.size()), h};
+    return static_cast<int>(e.index);
+}
+
+void ConstantPool::reserve(std::size_t entries, std::size_t string_bytes) {
+    pool_.reserve(entries);
+    blob_.reserve(string_bytes);
+    while (slots_.size() < entries * 2) grow();
+}
+
+// --- Primitive constants ---
+int ConstantPool::add_int(int32_t v) {
+    return add(Key{ConstTag::INT, static_cast<uint32_t>(v), {}});
 }
 
 int ConstantPool::add_float(float f) {
     uint32_t bits;
     std::memcpy(&bits, &f, sizeof(bits));
-    std::ostringstream oss; oss << "0x" << std::hex << bits;
-    std::string val = oss.str();
-
-    std::string key = make_key(ConstTag::FLOAT, val);
-    auto it = lookup_.find(key);
-    if (it != lookup_.end()) return it->second;
+    return add(Key{ConstTag::FLOAT, bits, {}});
+}
 
-    ConstEntry e{ConstTag::FLOAT, next_index_++, val};
-    pool_.push_back(e);
-    lookup_[key] = e.index;
-    return e.index;
+int ConstantPool::add_string(std::string_view s) {
+    return add(Key{ConstTag::STRING, 0, s});
 }
 
-int ConstantPool::add_string(const std::string &s) {
-    std::string key = make_key(ConstTag::STRING, s);
-    auto it = lookup_.find(key);
-    if (it != lookup_.end()) return it->second;
+float ConstantPool::float_value(const ConstEntry& e) const {
+    float f;
+    std::memcpy(&f, &e.bits, sizeof(f));
+    return f;
+}
 
-    ConstEntry e{ConstTag::STRING, next_index_++, s};
-    pool_.push_back(e);
-    lookup_[key] = e.index;
-    return e.index;
+std::string ConstantPool::text(const ConstEntry& e) const {
+    switch (e.tag) {
+        case ConstTag::INT:   return std::to_string(int_value(e));
+        case ConstTag::FLOAT: {
+            static const char digits[] = "0123456789abcdef";
+            char buf[11] = "0x";
+            int n = 2;
+            bool lead = true;
+            for (int shift = 28; shift >= 0; shift -= 4) {
+                unsigned d = (e.bits >> shift) & 0xF;
+                if (lead && d == 0 && shift) continue;
+                lead = false;
+                buf[n++] = digits[d];
+            }
+            return std::string(buf, n);
+        }
+        case ConstTag::STRING: return std::string(string_value(e));
+    }
+    return {};
 }
 
 // --- Size calculation ---
 uint32_t ConstantPool::size_bytes() const {
-    uint32_t sz = 0;
-    for (auto &e : pool_) {
-        sz += 1 + 4; // tag + index
-        switch (e.tag) {
-            case ConstTag::INT:   sz += 4; break;
-            case ConstTag::FLOAT: sz += 4; break;
-            case ConstTag::STRING: sz += 4 + (uint32_t)e.str.size(); break;
-        }
-    }
-    return sz;
+    // count and offset table, then per entry tag + index + a 4-byte value
+    // (int, float bits or string length), plus a string-table offset for
+    // every string
+    return static_cast<uint32_t>(4 + pool_.size() * 4 + pool_.size() * (1 + 4 + 4) +
+                                 string_count_ * 4);
 }
 
 // --- Emit to buffer ---
-void ConstantPool::emit(std::vector<uint8_t> &buf) const {
-    auto write_u8 = [&](uint8_t v) { buf.push_back(v); };
-    auto write_u32 = [&](uint32_t v) {
-        buf.push_back(v & 0xFF); buf.push_back((v >> 8) & 0xFF);
-        buf.push_back((v >> 16) & 0xFF); buf.push_back((v >> 24) & 0xFF);
-    };
+using vm::put_u32;
 
-    for (auto &e : pool_) {
-        write_u8((uint8_t)e.tag);
-        write_u32(e.index);
+void ConstantPool::add_strings(StringTable& strings) const {
+    for (const ConstEntry& e : pool_)
+        if (e.tag == ConstTag::STRING) strings.add(string_value(e));
+}
 
-        switch (e.tag) {
-            case ConstTag::INT:   write_u32(static_cast<uint32_t>(std::stoi(e.str))); break;
-            case ConstTag::FLOAT: {
-                uint32_t bits; std::stringstream ss(e.str); ss >> std::hex >> bits;
-                write_u32(bits); break;
-            }
-            case ConstTag::STRING:
-                write_u32((uint32_t)e.str.size());
-                buf.insert(buf.end(), e.str.begin(), e.str.end());
-                break;
+void ConstantPool::emit(std::vector<uint8_t> &buf, const StringTable& strings) const {
+    std::size_t start = buf.size();
+    buf.resize(start + size_bytes());
+    uint8_t* base = buf.data() + start;
+    uint8_t* offsets = put_u32(base, static_cast<uint32_t>(pool_.size()));
+    uint8_t* p = offsets + pool_.size() * 4;
+
+    for (const ConstEntry& e : pool_) {
+        offsets = put_u32(offsets, static_cast<uint32_t>(p - base));
+        *p++ = static_cast<uint8_t>(e.tag);
+        p = put_u32(p, e.index);
+        if (e.tag == ConstTag::STRING) {
+            p = put_u32(p, e.length);
+            p = put_u32(p, strings.offset(string_value(e)));
+        } else {
+            p = put_u32(p, e.bits);
         }
     }
 }
@@ -100,9 +165,9 @@ void ConstantPool::print() const {
     for (auto &e : pool_) {
         std::cout << "#" << e.index << " ";
         switch (e.tag) {
-            case ConstTag::INT:    std::cout << "INT " << e.str; break;
-            case ConstTag::FLOAT:  std::cout << "FLOAT " << e.str; break;
-            case ConstTag::STRING: std::cout << "STRING \"" << e.str << "\""; break;
+            case ConstTag::INT:    std::cout << "INT " << text(e); break;
+            case ConstTag::FLOAT:  std::cout << "FLOAT " << text(e); break;
+            case ConstTag::STRING: std::cout << "STRING \"" << text(e) << "\""; break;
         }
         std::cout << "\n";
     }
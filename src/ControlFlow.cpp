@@ -0,0 +1,129 @@
+// ============================================================================
+// ControlFlow.cpp - jump threading, label merging, unreachable code (-O)
+// ============================================================================
+#include "assembler/Optimizer.hpp"
+#include "assembler/Opcodes.hpp"
+
+namespace assembler {
+namespace opt {
+
+namespace {
+
+constexpr std::size_t NO_FIXUP = SIZE_MAX;
+
+bool is_branch(OpCode op) {
+    OperandType t = opcode_info(op).operand;
+    return t == OperandType::Branch || t == OperandType::RelBranch;
+}
+
+bool is_goto(OpCode op) {
+    return op == OpCode::JMP || op == OpCode::JMP_S || op == OpCode::JMP_W;
+}
+
+} // namespace
+
+std::size_t simplify_cfg(std::vector<Instruction>& program, SymbolTable& symtab,
+                         OptReport& report) {
+    const std::vector<LabelInfo>& labels = symtab.labels();
+    const std::vector<Fixup>& fixups = symtab.fixups();
+    const std::size_t n = program.size();
+    std::size_t changes = 0;
+
+    auto retarget = [&](std::size_t k, SymbolId to) {
+        const Fixup& f = fixups[k];
+        program[f.instr_index].operands[f.operand_index].sym = to;
+        symtab.retarget_fixup(k, to);
+    };
+
+    // Labels at the same instruction are one label: every reference names
+    // the lowest id, so the passes below compare targets by id.
+    std::vector<SymbolId> canonical(n + 1, NO_SYMBOL);
+    for (SymbolId id = 0; id < labels.size(); ++id) {
+        if (labels[id].defined && canonical[labels[id].instr_index] == NO_SYMBOL)
+            canonical[labels[id].instr_index] = id;
+    }
+    std::vector<std::size_t> fixup_at(n, NO_FIXUP);
+    for (std::size_t k = 0; k < fixups.size(); ++k) {
+        const Fixup& f = fixups[k];
+        if (f.kind != FixupKind::Label) continue;
+        fixup_at[f.instr_index] = k;
+        auto label = symtab.get_label(f.target);
+        if (!label.first) continue;   // undefined labels are reported in pass 2
+        SymbolId c = canonical[label.second.instr_index];
+        if (c != f.target) {
+            retarget(k, c);
+            report.hit("merge-labels");
+            ++changes;
+        }
+    }
+
+    // A jump to a JMP goes straight to that JMP's target. The hop limit
+    // ends chains that loop (JMP A; A: JMP A).
+    for (std::size_t k = 0; k < fixups.size(); ++k) {
+        const Fixup& f = fixups[k];
+        if (f.kind != FixupKind::Label || !is_branch(program[f.instr_index].op)) continue;
+        SymbolId dest = f.target;
+        for (std::size_t hops = 0; hops < n; ++hops) {
+            auto label = symtab.get_label(dest);
+            if (!label.first) break;
+            uint32_t t = label.second.instr_index;
+            if (t >= n || t == f.instr_index || !is_goto(program[t].op) ||
+                fixup_at[t] == NO_FIXUP)
+                break;
+            SymbolId next = fixups[fixup_at[t]].target;
+            if (!symtab.get_label(next).first || next == dest) break;
+            dest = next;
+        }
+        if (dest != f.target) {
+            retarget(k, dest);
+            report.hit("thread-jump");
+            ++changes;
+        }
+    }
+
+    // Delete what no path reaches inside a method. Method entries and every
+    // instruction outside a method's range are roots. A method pinned with
+    // an explicit address has no range, so its code is one of those roots
+    // and is never deleted. A branch whose target is not a known label
+    // could go anywhere, so then nothing is deleted.
+    std::vector<uint8_t> live(n, 0);
+    std::vector<uint32_t> work;
+    auto reach = [&](std::size_t i) {
+        if (i < n && !live[i]) {
+            live[i] = 1;
+            work.push_back(static_cast<uint32_t>(i));
+        }
+    };
+    std::vector<uint8_t> in_method(n, 0);
+    for (const auto& kv : symtab.methods()) {
+        const MethodInfo& mi = kv.second;
+        if (mi.first_instr == NO_INDEX || mi.end_instr == NO_INDEX) continue;
+        for (uint32_t i = mi.first_instr; i < mi.end_instr && i < n; ++i) in_method[i] = 1;
+        reach(mi.first_instr);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!in_method[i]) reach(i);
+        if (is_branch(program[i].op) &&
+            (fixup_at[i] == NO_FIXUP || !symtab.get_label(fixups[fixup_at[i]].target).first))
+            return changes;
+    }
+    while (!work.empty()) {
+        uint32_t i = work.back();
+        work.pop_back();
+        OpCode op = program[i].op;
+        if (is_branch(op)) reach(symtab.get_label(fixups[fixup_at[i]].target).second.instr_index);
+        if (!is_goto(op) && op != OpCode::RET) reach(i + 1);
+    }
+
+    std::size_t dead = 0;
+    for (std::size_t i = 0; i < n; ++i) dead += !live[i];
+    if (dead) {
+        compact(program, symtab, live);
+        report.hit("unreachable", dead);
+        changes += dead;
+    }
+    return changes;
+}
+
+} // namespace opt
+} // namespace assembler
@@ -1,118 +1,219 @@
 #include "assembler/Emitter.hpp"
 #include "assembler/SymbolTable.hpp"
+#include "assembler/VMFormat.hpp"
+#include "assembler/Log.hpp"
+#include <algorithm>
 #include <fstream>
-#include <iostream>
 
 using namespace assembler;
 
-void BinaryWriter::writeBytes(const std::vector<uint8_t>& v) {
-    buf.insert(buf.end(), v.begin(), v.end());
+void BinaryWriter::write(uint32_t v) {
+    uint8_t b[4];
+    vm::put_u32(b, v);
+    buf.insert(buf.end(), b, b + 4);
 }
 
-void BinaryWriter::writeString(const std::string& s) {
-    uint8_t len = static_cast<uint8_t>(s.size());
-    write(len);
-    buf.insert(buf.end(), s.begin(), s.end());
+void assembler::addMetadataNames(const SymbolTable& symtab, StringTable& strings) {
+    const Interner& names = symtab.names();
+    for (const auto& pair : symtab.classes()) {
+        const auto& ci = pair.second;
+        strings.add(names.name(ci.name));
+        for (const auto& f : ci.fields) strings.add(names.name(f.name));
+        for (const auto& mkey : ci.methods) {
+            auto it = symtab.methods().find(mkey);
+            if (it != symtab.methods().end()) strings.add(names.name(it->second.name));
+        }
+    }
+    for (const MethodInfo* mi : functionOrder(symtab)) strings.add(names.name(mi->name));
+}
+
+std::vector<const MethodInfo*> assembler::functionOrder(const SymbolTable& symtab) {
+    const Interner& names = symtab.names();
+    std::vector<uint8_t> in_class(names.size(), 0);
+    for (const auto& pair : symtab.classes())
+        for (SymbolId mkey : pair.second.methods) in_class[mkey] = 1;
+
+    std::vector<const MethodInfo*> functions;
+    for (const auto& pair : symtab.methods())
+        if (!in_class[pair.first]) functions.push_back(&pair.second);
+    std::sort(functions.begin(), functions.end(), [&](const MethodInfo* a, const MethodInfo* b) {
+        return names.name(a->name) < names.name(b->name);
+    });
+    return functions;
+}
+
+std::vector<const ClassInfo*> assembler::metadataOrder(const SymbolTable& symtab,
+                                                       std::vector<std::string>* errors) {
+    const Interner& names = symtab.names();
+    std::vector<const ClassInfo*> by_name;
+    by_name.reserve(symtab.classes().size());
+    for (const auto& pair : symtab.classes()) by_name.push_back(&pair.second);
+    std::sort(by_name.begin(), by_name.end(), [&](const ClassInfo* a, const ClassInfo* b) {
+        return names.name(a->name) < names.name(b->name);
+    });
+
+    // Superclasses first: each class in name order pulls in its chain of
+    // not yet placed superclasses, outermost first. A cycle stops at the
+    // first class already on the chain, and is reported from there.
+    enum : uint8_t { FREE, ON_CHAIN, PLACED };
+    std::vector<uint8_t> state(names.size(), FREE);
+    std::vector<const ClassInfo*> order, chain;
+    order.reserve(by_name.size());
+    for (const ClassInfo* ci : by_name) {
+        const ClassInfo* c = ci;
+        while (c && state[c->name] == FREE) {
+            state[c->name] = ON_CHAIN;
+            chain.push_back(c);
+            auto it = c->super_name == NO_SYMBOL ? symtab.classes().end()
+                                                 : symtab.classes().find(c->super_name);
+            c = it == symtab.classes().end() ? nullptr : &it->second;
+        }
+        if (c && state[c->name] == ON_CHAIN && errors) {
+            std::string msg = "Superclass cycle:";
+            auto from = std::find(chain.begin(), chain.end(), c);
+            for (auto k = from; k != chain.end(); ++k)
+                msg += " " + std::string(names.name((*k)->name)) + " extends";
+            errors->push_back(msg + " " + std::string(names.name(c->name)));
+        }
+        for (const ClassInfo* p : chain) state[p->name] = PLACED;
+        order.insert(order.end(), chain.rbegin(), chain.rend());
+        chain.clear();
+    }
+    return order;
 }
 
-void assembler::writeVMFile(
+bool assembler::writeVMFile(
     const std::string& filename,
+    const std::vector<uint8_t>& pool,
     const std::vector<uint8_t>& code,
-    const SymbolTable& symtab
+    const SymbolTable& symtab,
+    const StringTable& strings
 ) {
-    BinaryWriter writer;
-
-    // --- Build Header ---
-    Header hdr{};
-    hdr.magic = 0x01004D56;   // "VM\1"
-    hdr.version = 1;
-    hdr.entryPoint = 0;        // will be patched later
-
-    hdr.constPoolOffset = sizeof(Header);
-    hdr.constPoolSize   = 0;
-
-    hdr.codeOffset = sizeof(Header);
-    hdr.codeSize   = code.size();
-
-    hdr.globalsOffset = hdr.codeOffset + hdr.codeSize;
-    hdr.globalsSize   = 0;
-
-    hdr.classMetadataOffset = hdr.globalsOffset;
-
-    writer.write(hdr);
-
-    // --- Write code ---
-    writer.writeBytes(code);
-
-    // --- Write class metadata ---
-    size_t classMetaStart = writer.data().size();
-
-    const auto& classes = symtab.classes();
-    writer.write(static_cast<uint32_t>(classes.size()));
-
-    uint32_t mainOffset = 0;
-
-    for (const auto& pair : classes) {
-        const auto& ci = pair.second;
-        writer.writeString(ci.name);
-
-        // Superclass index
-        int32_t superIndex = -1;
-        if (!ci.super_name.empty()) {
-            size_t idx = 0;
-            for (const auto& otherPair : classes) {
-                if (otherPair.second.name == ci.super_name) {
-                    superIndex = static_cast<int32_t>(idx);
-                    break;
-                }
-                ++idx;
-            }
+    // Only the class metadata is built in memory; the pool, code and
+    // strings are written to the file straight from their buffers.
+    const Interner& names = symtab.names();
+    const auto& methods = symtab.methods();
+
+    // --- Build class metadata: fixed-size class, field and method records ---
+    std::vector<const ClassInfo*> order = metadataOrder(symtab);
+
+    // Class index by name id; names are dense, so this is a plain array.
+    std::vector<uint32_t> index_of(names.size(), vm::NO_CLASS);
+    for (size_t i = 0; i < order.size(); ++i)
+        index_of[order[i]->name] = static_cast<uint32_t>(i);
+
+    BinaryWriter classRecs, fieldRecs, methodRecs, functionRecs;
+    uint32_t fieldCount = 0, methodCount = 0;
+    auto writeMethod = [&](BinaryWriter& w, const MethodInfo& mi) {
+        w.write(strings.offset(names.name(mi.name)));
+        w.write(mi.address - symtab.base());   // offset into the code
+        w.write(mi.size);
+        w.write(mi.stack_limit);
+        w.write(mi.locals_limit);
+    };
+    for (const ClassInfo* ci : order) {
+        uint32_t firstField = fieldCount, firstMethod = methodCount;
+        for (const auto& f : ci->fields) {
+            fieldRecs.write(strings.offset(names.name(f.name)));
+            fieldRecs.write(f.pool_index);
+            ++fieldCount;
         }
-        writer.write(superIndex);
-
-        // Fields
-        writer.write(static_cast<uint32_t>(ci.fields.size()));
-        for (const auto& f : ci.fields) {
-            writer.writeString(f.name);
-            writer.write(f.pool_index);
+        // Methods, in declaration order
+        for (SymbolId mkey : ci->methods) {
+            auto it = methods.find(mkey);
+            if (it == methods.end()) continue;
+            writeMethod(methodRecs, it->second);
+            ++methodCount;
         }
 
-        // Methods
-        // Methods
-writer.write(static_cast<uint32_t>(ci.methods.size()));
-for (const auto& mkey : ci.methods) {
-    std::pair<bool, MethodInfo> result = symtab.get_method(mkey);
-    if (!result.first) continue;
-    const MethodInfo& mi = result.second;
-    writer.writeString(mi.name);
-    writer.write(mi.address);
-
-}
-
+        classRecs.write(strings.offset(names.name(ci->name)));
+        // Superclass index, NO_CLASS for none or a class that is not defined
+        classRecs.write(ci->super_name == NO_SYMBOL ? vm::NO_CLASS : index_of[ci->super_name]);
+        classRecs.write(firstField);
+        classRecs.write(fieldCount - firstField);
+        classRecs.write(firstMethod);
+        classRecs.write(methodCount - firstMethod);
     }
-    
- std::pair<bool, MethodInfo> result = symtab.get_method("main");
-if (result.first)
-{
-    mainOffset = result.second.address;
-}
 
+    // Methods outside any class, by name
+    std::vector<const MethodInfo*> functions = functionOrder(symtab);
+    for (const MethodInfo* mi : functions) writeMethod(functionRecs, *mi);
 
-    // Patch header
-    size_t classMetaEnd = writer.data().size();
-    uint32_t classMetaSize = classMetaEnd - classMetaStart;
+    uint32_t mainOffset = 0;
+    auto mainIt = methods.find(names.find("main"));
+    if (mainIt != methods.end()) mainOffset = mainIt->second.address - symtab.base();
+
+    // --- Lay out the sections, each on an ALIGN boundary ---
+    struct Part {
+        vm::Section    kind;
+        const uint8_t* data;
+        size_t         size;
+        uint32_t       count;
+        uint32_t       offset;
+    };
+    const std::string& table = strings.data();
+    Part parts[] = {
+        {vm::Section::POOL, pool.data(), pool.size(),
+         pool.size() >= 4 ? vm::get_u32(pool.data()) : 0, 0},
+        {vm::Section::CODE, code.data(), code.size(), 0, 0},
+        {vm::Section::CLASSES, classRecs.data().data(), classRecs.data().size(),
+         static_cast<uint32_t>(order.size()), 0},
+        {vm::Section::FIELDS, fieldRecs.data().data(), fieldRecs.data().size(), fieldCount, 0},
+        {vm::Section::METHODS, methodRecs.data().data(), methodRecs.data().size(), methodCount, 0},
+        {vm::Section::FUNCTIONS, functionRecs.data().data(), functionRecs.data().size(),
+         static_cast<uint32_t>(functions.size()), 0},
+        {vm::Section::STRINGS, reinterpret_cast<const uint8_t*>(table.data()), table.size(), 0, 0},
+    };
+    const uint32_t sectionCount = sizeof(parts) / sizeof(parts[0]);
+
+    uint64_t end = vm::HEADER_SIZE + uint64_t(sectionCount) * vm::DIR_ENTRY_SIZE;
+    for (Part& part : parts) {
+        end = (end + vm::ALIGN - 1) & ~uint64_t(vm::ALIGN - 1);
+        part.offset = static_cast<uint32_t>(end);
+        end += part.size;
+    }
+    if (end > UINT32_MAX) {
+        LOG_ERROR("VM file " << filename << " would exceed 4 GiB");
+        return false;
+    }
 
-    Header* hdrPtr = (Header*)writer.data().data();
-    hdrPtr->classMetadataOffset = classMetaStart;
-    hdrPtr->classMetadataSize   = classMetaSize;
-    hdrPtr->entryPoint          = mainOffset;
+    // --- Header and section directory ---
+    BinaryWriter head;
+    head.write(vm::MAGIC);
+    head.write(vm::VERSION);
+    head.write(vm::HEADER_SIZE);
+    head.write(vm::ALIGN);
+    head.write(mainOffset);
+    head.write(sectionCount);
+    head.write(vm::HEADER_SIZE);          // directory right after the header
+    head.write(static_cast<uint32_t>(end));
+    while (head.data().size() < vm::HEADER_SIZE) head.write(0);
+    for (const Part& part : parts) {
+        head.write(static_cast<uint32_t>(part.kind));
+        head.write(part.offset);
+        head.write(static_cast<uint32_t>(part.size));
+        head.write(part.count);
+    }
 
-    // --- Write to file ---
+    // --- Write to file, zero-padding up to each section ---
+    static const char zeros[vm::ALIGN] = {};
     std::ofstream out(filename, std::ios::binary);
-    out.write((char*)writer.data().data(), writer.data().size());
+    out.write((const char*)head.data().data(), head.data().size());
+    uint64_t at = head.data().size();
+    for (const Part& part : parts) {
+        out.write(zeros, part.offset - at);
+        out.write((const char*)part.data, part.size);
+        at = part.offset + part.size;
+    }
+    if (!out.flush()) {
+        LOG_ERROR("could not write VM file: " << filename);
+        return false;
+    }
 
-    std::cout << "[Emitter] VM file written: " << filename
-              << ", code size: " << code.size()
-              << ", classes: " << classes.size()
-              << ", main offset: " << mainOffset << std::endl;
-}
\ No newline at end of file
+    LOG_INFO("VM file written: " << filename
+             << ", pool size: " << pool.size()
+             << ", code size: " << code.size()
+             << ", classes: " << order.size()
+             << ", main offset: " << mainOffset);
+    return true;
+}
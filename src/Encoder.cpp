@@ -0,0 +1,134 @@
+// ============================================================================
+// Encoder.cpp - instructions straight to code-section bytes
+// ============================================================================
+#include "assembler/Encoder.hpp"
+#include "assembler/Opcodes.hpp"
+#include <cstdlib>
+#include <sstream>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+
+namespace assembler {
+
+static bool parse_int32(const std::string &s, int32_t &out) {
+    errno = 0;
+    char *endp = nullptr;
+    long val = std::strtol(s.c_str(), &endp, 0);
+    if (endp == s.c_str() || *endp != '\0') return false;
+    if (errno == ERANGE) return false;
+    if (val < INT32_MIN || val > INT32_MAX) return false;
+    out = static_cast<int32_t>(val);
+    return true;
+}
+
+static inline void put_le(uint8_t* p, uint32_t v, unsigned width) {
+    for (unsigned b = 0; b < width; ++b) p[b] = static_cast<uint8_t>(v >> (8 * b));
+}
+
+// Whether `v` survives a round trip through a `width`-byte slot.
+static bool fits(int64_t v, unsigned width, bool is_signed) {
+    if (width >= 4) return is_signed ? v >= INT32_MIN && v <= INT32_MAX : v >= 0 && v <= UINT32_MAX;
+    int64_t span = int64_t(1) << (8 * width);
+    return is_signed ? v >= -span / 2 && v < span / 2 : v >= 0 && v < span;
+}
+
+Encoder::Report Encoder::encode(const std::vector<Instruction>& program,
+                                const Interner& names,
+                                const std::vector<Fixup>& fixups,
+                                std::size_t code_size) {
+    Report rep;
+    rep.code.resize(code_size);   // zero-filled: unencodable operands stay 0
+    rep.locs.reserve(program.size());
+
+    auto error = [&](const Instruction& ins, size_t i, size_t oi, const std::string& what) {
+        std::ostringstream os;
+        os << "encode error: " << what << " at line " << ins.src_line
+           << ", col " << ins.src_col << " (instr " << i << ", operand " << oi << ")";
+        rep.errors.push_back(os.str());
+    };
+
+    uint8_t* out = rep.code.data();
+    size_t pos = 0;
+    // Fixups are recorded in instruction order, so one cursor finds them.
+    size_t fx = 0;
+
+    for (size_t i = 0; i < program.size(); ++i) {
+        const Instruction &ins = program[i];
+        const OpcodeInfo& info = opcode_info(ins.op);
+        if (pos + info.size() > code_size) {
+            std::ostringstream os;
+            os << "encode error: code overruns the " << code_size
+               << " bytes counted in pass 1 at line " << ins.src_line;
+            rep.errors.push_back(os.str());
+            break;
+        }
+        rep.locs.push_back(SourceLoc{static_cast<uint32_t>(pos), ins.src_line, ins.src_col});
+        uint8_t* at = out + pos;
+        at[0] = static_cast<uint8_t>(ins.op);
+
+        for (size_t oi = 0; oi < ins.operands.size() && oi < info.operand_count(); ++oi) {
+            const Operand &op = ins.operands[oi];
+            uint8_t* slot = at + info.operand_offset(oi);
+            unsigned width = info.operand_width(oi);
+            // Float operands are raw IEEE-754 bits: any int32 pattern goes.
+            bool sign = is_signed(info.operand_type(oi)) ||
+                        info.operand_type(oi) == OperandType::Float;
+            // Writes `v` unless it would be truncated; then the slot stays 0.
+            auto put = [&](int64_t v) {
+                if (fits(v, width, sign)) {
+                    put_le(slot, static_cast<uint32_t>(v), width);
+                    return;
+                }
+                std::ostringstream os;
+                os << "value " << v << " does not fit in a " << width << "-byte "
+                   << (sign ? "signed" : "unsigned") << " operand";
+                error(ins, i, oi, os.str());
+            };
+
+            switch (op.kind) {
+                case Operand::Kind::Immediate:
+                    put(op.imm);
+                    break;
+
+                case Operand::Kind::ConstPoolIndex:
+                    put(op.pool_index);
+                    break;
+
+                case Operand::Kind::Label: {
+                    while (fx < fixups.size() && fixups[fx].instr_index < i) ++fx;
+                    if (fx < fixups.size() && fixups[fx].instr_index == i &&
+                        fixups[fx].operand_index == oi && fixups[fx].resolved) {
+                        // Displacements are stored two's-complement in `value`.
+                        uint32_t v = fixups[fx++].value;
+                        put(sign ? int64_t(int32_t(v)) : int64_t(v));
+                        break;
+                    }
+                    int32_t val = 0;
+                    std::string label(names.name(op.sym));
+                    if (!parse_int32(label, val))
+                        error(ins, i, oi, "non-numeric label operand '" + label + "'");
+                    else
+                        put(val);
+                    break;
+                }
+
+                case Operand::Kind::FieldRef:
+                case Operand::Kind::Register:
+                case Operand::Kind::MethodRef:
+                    error(ins, i, oi, "unsupported operand kind");
+                    break;
+            }
+        }
+        pos += info.size();
+    }
+
+    if (pos != code_size && rep.errors.empty()) {
+        std::ostringstream os;
+        os << "encode error: encoded " << pos << " bytes, pass 1 counted " << code_size;
+        rep.errors.push_back(os.str());
+    }
+    return rep;
+}
+
+} // namespace assembler
@@ -0,0 +1,140 @@
+// ============================================================================
+// Fold.cpp - constant folding and algebraic identities (-O)
+// ============================================================================
+#include "assembler/Optimizer.hpp"
+#include "assembler/Opcodes.hpp"
+#include <climits>
+
+namespace assembler {
+namespace opt {
+
+namespace {
+
+// The VM's int arithmetic is 32-bit two's complement, so fold in uint32_t.
+bool fold_binary(OpCode op, int32_t a, int32_t b, int32_t& r) {
+    uint32_t ua = static_cast<uint32_t>(a), ub = static_cast<uint32_t>(b);
+    switch (op) {
+        case OpCode::IADD: r = static_cast<int32_t>(ua + ub); return true;
+        case OpCode::ISUB: r = static_cast<int32_t>(ua - ub); return true;
+        case OpCode::IMUL: r = static_cast<int32_t>(ua * ub); return true;
+        case OpCode::IDIV:
+            // Division by zero and INT_MIN / -1 trap at run time; keep them.
+            if (b == 0 || (a == INT32_MIN && b == -1)) return false;
+            r = a / b;
+            return true;
+        case OpCode::ICMP_EQ:  r = a == b; return true;
+        case OpCode::ICMP_NEQ: r = a != b; return true;
+        case OpCode::ICMP_LT:  r = a < b;  return true;
+        case OpCode::ICMP_GT:  r = a > b;  return true;
+        case OpCode::ICMP_LEQ: r = a <= b; return true;
+        case OpCode::ICMP_GEQ: r = a >= b; return true;
+        default: return false;
+    }
+}
+
+// x + 0, x - 0, x * 1, x / 1
+bool is_identity(OpCode op, int32_t b) {
+    switch (op) {
+        case OpCode::IADD:
+        case OpCode::ISUB: return b == 0;
+        case OpCode::IMUL:
+        case OpCode::IDIV: return b == 1;
+        default:           return false;
+    }
+}
+
+bool ends_block(OpCode op) {
+    OperandType t = opcode_info(op).operand;
+    return t == OperandType::Branch || t == OperandType::RelBranch || op == OpCode::RET;
+}
+
+} // namespace
+
+std::size_t fold_constants(std::vector<Instruction>& program, SymbolTable& symtab,
+                           OptReport& report) {
+    std::vector<uint8_t> boundary = boundaries(program, symtab);
+    std::vector<uint8_t> keep(program.size(), 1);
+    std::size_t folded = 0;
+
+    // The kept instructions since the block started, so the operands of an
+    // instruction are the last entries whenever they are literals. Folded
+    // results stay in place, which makes nested expressions fold in one pass.
+    std::vector<uint32_t> tail;
+    auto literal = [&](std::size_t back, int32_t& v) {
+        if (tail.size() <= back) return false;
+        const Instruction& p = program[tail[tail.size() - 1 - back]];
+        if (p.op != OpCode::PUSH || p.operands.size() != 1 ||
+            p.operands[0].kind != Operand::Kind::Immediate)
+            return false;
+        v = p.operands[0].imm;
+        return true;
+    };
+    auto drop_last = [&]() {
+        keep[tail.back()] = 0;
+        tail.pop_back();
+    };
+
+    for (std::size_t i = 0; i < program.size(); ++i) {
+        if (boundary[i]) tail.clear();
+        Instruction& ins = program[i];
+        int32_t a = 0, b = 0, r = 0;
+
+        // PUSH a; PUSH b; op  ->  PUSH (a op b)
+        if (literal(0, b) && literal(1, a) && fold_binary(ins.op, a, b, r)) {
+            drop_last();
+            program[tail.back()].operands[0].imm = r;
+            keep[i] = 0;
+            report.hit("fold-constant");
+            ++folded;
+            continue;
+        }
+        // PUSH 0; IADD  and the like
+        if (literal(0, b) && is_identity(ins.op, b)) {
+            drop_last();
+            keep[i] = 0;
+            report.hit("fold-identity");
+            ++folded;
+            continue;
+        }
+        if (ins.op == OpCode::INEG) {
+            // PUSH a; INEG  ->  PUSH -a   (-INT_MIN wraps to itself)
+            if (literal(0, a)) {
+                program[tail.back()].operands[0].imm =
+                    static_cast<int32_t>(0u - static_cast<uint32_t>(a));
+                keep[i] = 0;
+                report.hit("fold-constant");
+                ++folded;
+                continue;
+            }
+            // INEG; INEG
+            if (!tail.empty() && program[tail.back()].op == OpCode::INEG) {
+                drop_last();
+                keep[i] = 0;
+                report.hit("fold-identity");
+                ++folded;
+                continue;
+            }
+        }
+        // PUSH c; JZ/JNZ L  ->  JMP L when taken, nothing when not
+        if ((ins.op == OpCode::JZ || ins.op == OpCode::JNZ) && literal(0, a)) {
+            drop_last();
+            if ((ins.op == OpCode::JZ) == (a == 0)) ins.op = OpCode::JMP;
+            else keep[i] = 0;
+            report.hit("fold-branch");
+            ++folded;
+            tail.clear();
+            continue;
+        }
+
+        tail.push_back(static_cast<uint32_t>(i));
+        // Values before a branch are also seen by its target: never fold
+        // across one.
+        if (ends_block(ins.op)) tail.clear();
+    }
+
+    if (folded) compact(program, symtab, keep);
+    return folded;
+}
+
+} // namespace opt
+} // namespace assembler
@@ -0,0 +1,207 @@
+// ============================================================================
+// Fusion.cpp - superinstructions for hot opcode sequences (--fuse)
+// ============================================================================
+#include "assembler/Optimizer.hpp"
+#include "assembler/Keywords.hpp"
+#include <istream>
+#include <sstream>
+
+namespace assembler {
+
+namespace {
+
+struct Compare {
+    OpCode icmp;      // ICMP_xx
+    OpCode branch;    // IF_ICMPxx taken when ICMP_xx yields 1
+    OpCode inverse;   // IF_ICMPxx taken when ICMP_xx yields 0
+};
+
+constexpr Compare COMPARES[] = {
+    {OpCode::ICMP_EQ,  OpCode::IF_ICMPEQ,  OpCode::IF_ICMPNEQ},
+    {OpCode::ICMP_LT,  OpCode::IF_ICMPLT,  OpCode::IF_ICMPGEQ},
+    {OpCode::ICMP_GT,  OpCode::IF_ICMPGT,  OpCode::IF_ICMPLEQ},
+    {OpCode::ICMP_GEQ, OpCode::IF_ICMPGEQ, OpCode::IF_ICMPLT},
+    {OpCode::ICMP_NEQ, OpCode::IF_ICMPNEQ, OpCode::IF_ICMPEQ},
+    {OpCode::ICMP_LEQ, OpCode::IF_ICMPLEQ, OpCode::IF_ICMPGT},
+};
+
+const Compare* compare_of(OpCode op) {
+    for (const Compare& c : COMPARES)
+        if (c.icmp == op) return &c;
+    return nullptr;
+}
+
+// Each fusion, the option that enables it and the opcode pairs whose
+// execution counts decide whether a profile enables it.
+struct Fusion {
+    const char*    name;
+    bool OptOptions::* enabled;
+    bool (*covers)(OpCode first, OpCode second);
+};
+
+constexpr Fusion FUSIONS[] = {
+    {"iinc", &OptOptions::fuse_iinc, [](OpCode a, OpCode b) {
+         return (a == OpCode::IADD || a == OpCode::ISUB) && b == OpCode::STORE;
+     }},
+    {"if_icmp", &OptOptions::fuse_if_icmp, [](OpCode a, OpCode b) {
+         return compare_of(a) && (b == OpCode::JNZ || b == OpCode::JZ);
+     }},
+};
+
+bool is_imm(const Instruction& ins) {
+    return ins.operands.size() == 1 && ins.operands[0].kind == Operand::Kind::Immediate;
+}
+
+// p[load] is LOAD n and p[rest..rest+2] are PUSH k; IADD|ISUB; STORE n,
+// with n a one-byte slot and the signed delta fitting IINC's int8 operand.
+bool iinc_window(const std::vector<Instruction>& p, std::size_t load, std::size_t rest,
+                 int32_t& slot, int32_t& delta) {
+    if (rest + 3 > p.size()) return false;
+    const Instruction &ld = p[load], &push = p[rest], &arith = p[rest + 1], &store = p[rest + 2];
+    if (ld.op != OpCode::LOAD || push.op != OpCode::PUSH || store.op != OpCode::STORE ||
+        (arith.op != OpCode::IADD && arith.op != OpCode::ISUB))
+        return false;
+    if (!is_imm(ld) || !is_imm(push) || !is_imm(store)) return false;
+    slot = ld.operands[0].imm;
+    if (store.operands[0].imm != slot || slot < 0 || slot > 255) return false;
+    int64_t d = arith.op == OpCode::IADD ? int64_t(push.operands[0].imm)
+                                         : -int64_t(push.operands[0].imm);
+    if (d < -128 || d > 127) return false;
+    delta = static_cast<int32_t>(d);
+    return true;
+}
+
+void make_iinc(Instruction& ins, int32_t slot, int32_t delta) {
+    ins.op = OpCode::IINC;
+    ins.operands.clear();
+    ins.operands.push_back(Operand::immediate(slot));
+    ins.operands.push_back(Operand::immediate(delta));
+}
+
+bool no_boundary(const std::vector<uint8_t>& boundary, std::size_t i, std::size_t n) {
+    for (std::size_t k = 1; k < n; ++k)
+        if (boundary[i + k]) return false;
+    return true;
+}
+
+} // namespace
+
+void PairProfile::add(OpCode a, OpCode b, uint64_t n) {
+    counts[static_cast<uint16_t>((uint16_t(a) << 8) | uint8_t(b))] += n;
+    total += n;
+}
+
+uint64_t PairProfile::count(OpCode a, OpCode b) const {
+    auto it = counts.find(static_cast<uint16_t>((uint16_t(a) << 8) | uint8_t(b)));
+    return it == counts.end() ? 0 : it->second;
+}
+
+bool read_pair_profile(std::istream& in, PairProfile& profile, std::string& error) {
+    std::string line;
+    for (unsigned lineno = 1; std::getline(in, line); ++lineno) {
+        std::size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream ls(line);
+        std::string first, second;
+        if (!(ls >> first)) continue;
+        uint64_t n = 0;
+        const Keyword* a = find_keyword(first);
+        const Keyword* b = (ls >> second) ? find_keyword(second) : nullptr;
+        std::string rest;
+        if (!a || !b || a->op == OpCode::INVALID || b->op == OpCode::INVALID ||
+            !(ls >> n) || (ls >> rest)) {
+            error = "line " + std::to_string(lineno) + ": expected 'OPCODE OPCODE COUNT'";
+            return false;
+        }
+        profile.add(a->op, b->op, n);
+    }
+    return true;
+}
+
+bool enable_fusion(const std::string& name, OptOptions& opts) {
+    bool all = name == "all";
+    bool found = all;
+    for (const Fusion& f : FUSIONS) {
+        if (all || name == f.name) {
+            opts.*f.enabled = true;
+            found = true;
+        }
+    }
+    return found;
+}
+
+std::vector<std::string> select_fusions(const PairProfile& profile, double min_share,
+                                        OptOptions& opts) {
+    std::vector<std::string> chosen;
+    if (profile.total == 0) return chosen;
+    for (const Fusion& f : FUSIONS) {
+        uint64_t hits = 0;
+        for (const auto& kv : profile.counts)
+            if (f.covers(OpCode(kv.first >> 8), OpCode(kv.first & 0xFF))) hits += kv.second;
+        if (double(hits) >= min_share * double(profile.total)) {
+            opts.*f.enabled = true;
+            chosen.push_back(f.name);
+        }
+    }
+    return chosen;
+}
+
+namespace opt {
+
+std::size_t fuse(std::vector<Instruction>& program, SymbolTable& symtab,
+                 const OptOptions& opts, OptReport& report) {
+    std::vector<uint8_t> boundary = boundaries(program, symtab);
+    std::vector<SymbolId> target = branch_targets(program, symtab);
+    std::vector<uint8_t> keep(program.size(), 1);
+    std::size_t fused = 0;
+
+    for (std::size_t i = 0; i < program.size();) {
+        int32_t slot = 0, delta = 0;
+
+        // LOAD n; PUSH k; IADD; STORE n  ->  IINC n,k
+        if (opts.fuse_iinc && iinc_window(program, i, i + 1, slot, delta) &&
+            no_boundary(boundary, i, 4)) {
+            make_iinc(program[i], slot, delta);
+            keep[i + 1] = keep[i + 2] = keep[i + 3] = 0;
+            report.hit("fuse-iinc");
+            ++fused;
+            i += 4;
+            continue;
+        }
+
+        // LOAD n; DUP; PUSH k; IADD; STORE n  ->  LOAD n; IINC n,k
+        // (a post-increment whose old value stays on the stack)
+        if (opts.fuse_iinc && i + 1 < program.size() && program[i + 1].op == OpCode::DUP &&
+            iinc_window(program, i, i + 2, slot, delta) && no_boundary(boundary, i, 5)) {
+            make_iinc(program[i + 1], slot, delta);
+            keep[i + 2] = keep[i + 3] = keep[i + 4] = 0;
+            report.hit("fuse-iinc");
+            ++fused;
+            i += 5;
+            continue;
+        }
+
+        // ICMP_xx; JNZ L  ->  IF_ICMPxx L    (JZ takes the inverse test)
+        if (opts.fuse_if_icmp && i + 2 <= program.size() && no_boundary(boundary, i, 2)) {
+            const Compare* c = compare_of(program[i].op);
+            OpCode j = program[i + 1].op;
+            // Only label jumps: a numeric target is absolute, IF_ICMPxx is not.
+            if (c && (j == OpCode::JNZ || j == OpCode::JZ) && target[i + 1] != NO_SYMBOL) {
+                // The jump keeps its index, so its label fixup stays put.
+                program[i + 1].op = j == OpCode::JNZ ? c->branch : c->inverse;
+                keep[i] = 0;
+                report.hit("fuse-if_icmp");
+                ++fused;
+                i += 2;
+                continue;
+            }
+        }
+        ++i;
+    }
+
+    if (fused) compact(program, symtab, keep);
+    return fused;
+}
+
+} // namespace opt
+} // namespace assembler
@@ -0,0 +1,110 @@
+// ============================================================================
+// Input.cpp - source input: memory-mapped files and chunked stream reads
+// ============================================================================
+#include "assembler/Input.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace assembler;
+
+#ifdef _WIN32
+static int   sys_open(const char* p)                 { return ::_open(p, _O_RDONLY | _O_BINARY); }
+static long  sys_read(int fd, char* b, std::size_t n) { return ::_read(fd, b, (unsigned)n); }
+static void  sys_close(int fd)                        { ::_close(fd); }
+#else
+static int   sys_open(const char* p)                 { return ::open(p, O_RDONLY); }
+static long  sys_read(int fd, char* b, std::size_t n) { return (long)::read(fd, b, n); }
+static void  sys_close(int fd)                        { ::close(fd); }
+#endif
+
+// ---------------------------------------------------------------------------
+// SourceFile
+// ---------------------------------------------------------------------------
+
+SourceFile::~SourceFile() { release(); }
+
+SourceFile::SourceFile(SourceFile&& o) noexcept
+    : fd_(o.fd_), owns_fd_(o.owns_fd_), data_(o.data_), size_(o.size_) {
+    o.fd_ = -1; o.owns_fd_ = false; o.data_ = nullptr; o.size_ = 0;
+}
+
+SourceFile& SourceFile::operator=(SourceFile&& o) noexcept {
+    if (this != &o) {
+        release();
+        fd_ = o.fd_; owns_fd_ = o.owns_fd_; data_ = o.data_; size_ = o.size_;
+        o.fd_ = -1; o.owns_fd_ = false; o.data_ = nullptr; o.size_ = 0;
+    }
+    return *this;
+}
+
+void SourceFile::release() {
+#ifndef _WIN32
+    if (data_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+    if (owns_fd_ && fd_ >= 0) sys_close(fd_);
+    fd_ = -1; owns_fd_ = false; data_ = nullptr; size_ = 0;
+}
+
+SourceFile SourceFile::open(const std::string& path) {
+    SourceFile f;
+    if (path == "-") {
+        f.fd_ = 0;
+        return f;
+    }
+    f.fd_ = sys_open(path.c_str());
+    if (f.fd_ < 0) return f;
+    f.owns_fd_ = true;
+
+#ifndef _WIN32
+    struct stat st;
+    if (::fstat(f.fd_, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = ::mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, f.fd_, 0);
+        if (p != MAP_FAILED) {
+            ::madvise(p, (std::size_t)st.st_size, MADV_SEQUENTIAL);
+            f.data_ = static_cast<const char*>(p);
+            f.size_ = (std::size_t)st.st_size;
+            return f;
+        }
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(f.fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
+    return f;
+}
+
+// ---------------------------------------------------------------------------
+// StreamBuffer
+// ---------------------------------------------------------------------------
+
+StreamBuffer::StreamBuffer(int fd, std::size_t capacity)
+    : fd_(fd), buf_(capacity ? capacity : 1) {}
+
+bool StreamBuffer::refill(std::size_t keep) {
+    if (keep > 0) {
+        std::memmove(buf_.data(), buf_.data() + keep, len_ - keep);
+        len_ -= keep;
+    }
+    if (eof_) return false;
+    if (len_ == buf_.size()) buf_.resize(buf_.size() * 2);   // token > buffer
+
+    long got;
+    do {
+        got = sys_read(fd_, buf_.data() + len_, buf_.size() - len_);
+    } while (got < 0 && errno == EINTR);
+    if (got <= 0) {
+        if (got < 0) error_ = errno;
+        eof_ = true;
+        return false;
+    }
+    len_ += (std::size_t)got;
+    return true;
+}
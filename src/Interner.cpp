@@ -0,0 +1,43 @@
+// ============================================================================
+// Interner.cpp - identifier interning
+// ============================================================================
+#include "assembler/Interner.hpp"
+#include <cstring>
+
+namespace assembler {
+
+std::string_view Interner::store(std::string_view s) {
+    if (s.empty()) return {};
+    if (s.size() > BLOCK) {
+        // Oversized names get a block of their own.
+        blocks_.emplace_back(new char[s.size()]);
+        block_used_ = BLOCK;
+        std::memcpy(blocks_.back().get(), s.data(), s.size());
+        return {blocks_.back().get(), s.size()};
+    }
+    if (BLOCK - block_used_ < s.size()) {
+        blocks_.emplace_back(new char[BLOCK]);
+        block_used_ = 0;
+    }
+    char* p = blocks_.back().get() + block_used_;
+    std::memcpy(p, s.data(), s.size());
+    block_used_ += s.size();
+    return {p, s.size()};
+}
+
+SymbolId Interner::intern(std::string_view s) {
+    auto it = ids_.find(s);
+    if (it != ids_.end()) return it->second;
+    std::string_view owned = store(s);
+    SymbolId id = static_cast<SymbolId>(names_.size());
+    names_.push_back(owned);
+    ids_.emplace(owned, id);
+    return id;
+}
+
+SymbolId Interner::find(std::string_view s) const {
+    auto it = ids_.find(s);
+    return it == ids_.end() ? NO_SYMBOL : it->second;
+}
+
+} // namespace assembler
@@ -0,0 +1,104 @@
+// ============================================================================
+// Layout.cpp - instruction offsets and branch relaxation
+// ============================================================================
+#include "assembler/Layout.hpp"
+#include "assembler/Opcodes.hpp"
+
+namespace assembler {
+
+namespace {
+
+// The encodings of one jump, smallest first; the last one always reaches.
+struct JumpForms {
+    OpCode form[3];   // unused trailing entries are INVALID
+};
+
+constexpr JumpForms JUMPS[] = {
+    {{OpCode::JMP_S, OpCode::JMP, OpCode::JMP_W}},
+    {{OpCode::JZ_S,  OpCode::JZ,  OpCode::JZ_W}},
+    {{OpCode::JNZ_S, OpCode::JNZ, OpCode::JNZ_W}},
+    {{OpCode::IF_ICMPEQ,  OpCode::IF_ICMPEQ_W,  OpCode::INVALID}},
+    {{OpCode::IF_ICMPLT,  OpCode::IF_ICMPLT_W,  OpCode::INVALID}},
+    {{OpCode::IF_ICMPGT,  OpCode::IF_ICMPGT_W,  OpCode::INVALID}},
+    {{OpCode::IF_ICMPGEQ, OpCode::IF_ICMPGEQ_W, OpCode::INVALID}},
+    {{OpCode::IF_ICMPNEQ, OpCode::IF_ICMPNEQ_W, OpCode::INVALID}},
+    {{OpCode::IF_ICMPLEQ, OpCode::IF_ICMPLEQ_W, OpCode::INVALID}},
+};
+
+const JumpForms* forms_of(OpCode op) {
+    for (const JumpForms& j : JUMPS)
+        for (OpCode f : j.form)
+            if (f == op) return &j;
+    return nullptr;
+}
+
+struct Jump {
+    std::size_t      instr;
+    uint32_t         target;    // instruction index the label precedes
+    const JumpForms* forms;
+    unsigned         form;      // index into forms->form
+};
+
+} // namespace
+
+bool reaches(OpCode op, int64_t target, int64_t next) {
+    const OpcodeInfo& info = opcode_info(op);
+    int bits = 8 * info.width;
+    if (bits >= 32) return true;
+    if (info.operand == OperandType::RelBranch) {
+        int64_t disp = target - next;
+        return disp >= -(int64_t(1) << (bits - 1)) && disp < (int64_t(1) << (bits - 1));
+    }
+    return target >= 0 && target < (int64_t(1) << bits);
+}
+
+std::vector<uint32_t> layout_offsets(const std::vector<Instruction>& program) {
+    std::vector<uint32_t> offsets(program.size() + 1);
+    uint32_t pos = 0;
+    for (std::size_t i = 0; i < program.size(); ++i) {
+        offsets[i] = pos;
+        pos += static_cast<uint32_t>(encoded_size(program[i].op));
+    }
+    offsets[program.size()] = pos;
+    return offsets;
+}
+
+RelaxReport relax_branches(std::vector<Instruction>& program, const SymbolTable& symtab) {
+    RelaxReport rep;
+
+    std::vector<Jump> jumps;
+    for (const Fixup& f : symtab.fixups()) {
+        if (f.kind != FixupKind::Label) continue;
+        const JumpForms* forms = forms_of(program[f.instr_index].op);
+        auto label = symtab.get_label(f.target);
+        if (!forms || !label.first) continue;   // undefined labels are reported later
+        jumps.push_back(Jump{f.instr_index, label.second.instr_index, forms, 0});
+        program[f.instr_index].op = forms->form[0];
+    }
+
+    rep.offsets = layout_offsets(program);
+    for (bool grew = true; grew;) {
+        grew = false;
+        ++rep.passes;
+        for (Jump& j : jumps) {
+            OpCode op = j.forms->form[j.form];
+            int64_t base = symtab.base();
+            if (reaches(op, base + rep.offsets[j.target], base + rep.offsets[j.instr + 1]))
+                continue;
+            program[j.instr].op = j.forms->form[++j.form];
+            grew = true;
+        }
+        if (grew) rep.offsets = layout_offsets(program);
+    }
+
+    for (const Jump& j : jumps) {
+        const OpcodeInfo& info = opcode_info(j.forms->form[j.form]);
+        if (info.width == 4)                             ++rep.abs32;
+        else if (info.operand == OperandType::Branch)    ++rep.abs16;
+        else if (info.width == 1)                        ++rep.rel8;
+        else                                             ++rep.rel16;
+    }
+    return rep;
+}
+
+} // namespace assembler
@@ -0,0 +1,160 @@
+// ============================================================================
+// Locals.cpp - liveness-based local slot coalescing (-O)
+// ============================================================================
+#include "assembler/Optimizer.hpp"
+#include "assembler/Analysis.hpp"
+#include <algorithm>
+
+namespace assembler {
+namespace opt {
+
+namespace {
+
+// Methods with more distinct slots than this are left alone: the
+// interference matrix is slots^2 bits.
+constexpr std::size_t MAX_SLOTS = 1024;
+
+struct Bits {
+    std::vector<uint64_t> w;
+    explicit Bits(std::size_t n = 0) : w((n + 63) / 64, 0) {}
+    bool test(std::size_t i) const { return (w[i / 64] >> (i % 64)) & 1; }
+    void set(std::size_t i) { w[i / 64] |= uint64_t(1) << (i % 64); }
+    void reset(std::size_t i) { w[i / 64] &= ~(uint64_t(1) << (i % 64)); }
+    // this |= (a & ~b); returns whether this changed
+    bool merge(const Bits& a, const Bits& b) {
+        bool changed = false;
+        for (std::size_t k = 0; k < w.size(); ++k) {
+            uint64_t v = w[k] | (a.w[k] & ~b.w[k]);
+            changed |= v != w[k];
+            w[k] = v;
+        }
+        return changed;
+    }
+};
+
+bool reads(OpCode op)  { return op == OpCode::LOAD || op == OpCode::IINC; }
+bool writes(OpCode op) { return op == OpCode::STORE || op == OpCode::IINC; }
+
+// Renumbers the slots of one method; returns the slots saved.
+uint32_t coalesce(std::vector<Instruction>& program, const SymbolTable& symtab,
+                  const MethodInfo& mi) {
+    MethodCfg cfg = build_cfg(program, symtab, mi);
+    if (cfg.blocks.empty() || !cfg.complete) return 0;
+    uint32_t used = locals_used(program, mi);
+    if (used == NO_INDEX) return 0;
+
+    // Dense ids for the slots in use
+    std::vector<uint32_t> dense(used, NO_INDEX);
+    std::vector<uint32_t> slot_of;
+    for (uint32_t i = mi.first_instr; i < mi.end_instr; ++i) {
+        int64_t s = local_slot(program[i]);
+        if (s >= 0 && dense[s] == NO_INDEX) {
+            dense[s] = static_cast<uint32_t>(slot_of.size());
+            slot_of.push_back(static_cast<uint32_t>(s));
+        }
+    }
+    const std::size_t n = slot_of.size();
+    if (n < 2 || n > MAX_SLOTS) return 0;
+
+    // Per block: slots read before any write (use) and slots written (def)
+    std::size_t nb = cfg.blocks.size();
+    std::vector<Bits> use(nb, Bits(n)), def(nb, Bits(n)), live_in(nb, Bits(n)),
+                      live_out(nb, Bits(n));
+    for (std::size_t b = 0; b < nb; ++b) {
+        for (uint32_t i = cfg.blocks[b].first; i < cfg.blocks[b].end; ++i) {
+            int64_t s = local_slot(program[i]);
+            if (s < 0) continue;
+            uint32_t d = dense[s];
+            if (reads(program[i].op) && !def[b].test(d)) use[b].set(d);
+            if (writes(program[i].op)) def[b].set(d);
+        }
+    }
+    const Bits none(n);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (std::size_t b = nb; b-- > 0;) {
+            for (uint32_t s : cfg.blocks[b].succ)
+                if (s != NO_BLOCK) changed |= live_out[b].merge(live_in[s], none);
+            changed |= live_in[b].merge(use[b], none);
+            changed |= live_in[b].merge(live_out[b], def[b]);
+        }
+    }
+
+    // Two slots interfere when one is written while the other is live.
+    // Slots live on entry still hold their initial value, so they all
+    // interfere with each other.
+    std::vector<Bits> conflict(n, Bits(n));
+    auto interfere = [&](std::size_t a, std::size_t b) {
+        conflict[a].set(b);
+        conflict[b].set(a);
+    };
+    for (std::size_t b = 0; b < nb; ++b) {
+        Bits live = live_out[b];
+        for (uint32_t i = cfg.blocks[b].end; i-- > cfg.blocks[b].first;) {
+            int64_t s = local_slot(program[i]);
+            if (s < 0) continue;
+            uint32_t d = dense[s];
+            if (writes(program[i].op)) {
+                for (std::size_t o = 0; o < n; ++o)
+                    if (o != d && live.test(o)) interfere(d, o);
+                live.reset(d);
+            }
+            if (reads(program[i].op)) live.set(d);
+        }
+    }
+    for (std::size_t a = 0; a < n; ++a)
+        for (std::size_t b = a + 1; b < n; ++b)
+            if (live_in[0].test(a) && live_in[0].test(b)) interfere(a, b);
+
+    // Greedy colouring in slot order: every slot gets the lowest number no
+    // conflicting slot has taken, which is never above its own.
+    std::vector<uint32_t> order(n);
+    for (std::size_t k = 0; k < n; ++k) order[k] = static_cast<uint32_t>(k);
+    std::sort(order.begin(), order.end(),
+              [&](uint32_t a, uint32_t b) { return slot_of[a] < slot_of[b]; });
+    std::vector<uint32_t> color(n, NO_INDEX);
+    uint32_t colors = 0;
+    std::vector<uint8_t> taken;
+    for (uint32_t a : order) {
+        taken.assign(n, 0);
+        for (std::size_t b = 0; b < n; ++b)
+            if (color[b] != NO_INDEX && conflict[a].test(b)) taken[color[b]] = 1;
+        uint32_t c = 0;
+        while (taken[c]) ++c;
+        color[a] = c;
+        colors = std::max(colors, c + 1);
+    }
+    if (colors >= used) return 0;
+
+    for (uint32_t i = mi.first_instr; i < mi.end_instr; ++i) {
+        int64_t s = local_slot(program[i]);
+        if (s >= 0) program[i].operands[0].imm = static_cast<int32_t>(color[dense[s]]);
+    }
+    return used - colors;
+}
+
+} // namespace
+
+std::size_t coalesce_locals(std::vector<Instruction>& program, SymbolTable& symtab,
+                            OptReport& report) {
+    std::size_t saved = 0;
+    std::vector<std::pair<SymbolId, uint32_t>> shrunk;
+    for (const auto& kv : symtab.methods()) {
+        const MethodInfo& mi = kv.second;
+        if (mi.first_instr == NO_INDEX || mi.end_instr == NO_INDEX) continue;
+        uint32_t before = locals_used(program, mi);
+        uint32_t s = coalesce(program, symtab, mi);
+        if (!s) continue;
+        saved += s;
+        // A declared frame shrinks by what renumbering saved; one that was
+        // already too small is left for the limit check to report.
+        if (mi.has_locals_limit && mi.locals_limit >= before)
+            shrunk.emplace_back(kv.first, mi.locals_limit - s);
+    }
+    for (const auto& m : shrunk) symtab.set_locals_limit(m.first, m.second);
+    if (saved) report.hit("coalesce-locals", saved);
+    return saved;
+}
+
+} // namespace opt
+} // namespace assembler
@@ -0,0 +1,33 @@
+// ============================================================================
+// Log.cpp - leveled diagnostic logging
+// ============================================================================
+#include "assembler/Log.hpp"
+#include <iostream>
+
+namespace assembler {
+namespace log {
+
+namespace {
+Level         g_level  = Level::Warn;
+std::ostream* g_stream = nullptr;     // nullptr = std::cerr
+}
+
+void set_level(Level lvl) { g_level = lvl; }
+Level level() { return g_level; }
+
+void set_stream(std::ostream& out) { g_stream = &out; }
+std::ostream& stream() { return g_stream ? *g_stream : std::cerr; }
+
+const char* level_name(Level lvl) {
+    switch (lvl) {
+        case Level::Error: return "ERROR";
+        case Level::Warn:  return "WARN";
+        case Level::Info:  return "INFO";
+        case Level::Debug: return "DEBUG";
+        case Level::Trace: return "TRACE";
+    }
+    return "?";
+}
+
+} // namespace log
+} // namespace assembler
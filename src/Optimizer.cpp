@@ -0,0 +1,74 @@
+// ============================================================================
+// Optimizer.cpp - pass driver and the bookkeeping the passes share
+// ============================================================================
+#include "assembler/Optimizer.hpp"
+#include "assembler/Log.hpp"
+#include <utility>
+
+namespace assembler {
+
+void OptReport::hit(const char* rule, std::size_t n) {
+    for (Rule& r : rules) {
+        if (r.name == rule) {
+            r.hits += n;
+            return;
+        }
+    }
+    rules.push_back(Rule{rule, n});
+}
+
+void optimize(std::vector<Instruction>& program, SymbolTable& symtab,
+              const OptOptions& opts, OptReport& report) {
+    report.instrs_before = program.size();
+    if (opts.fold) opt::fold_constants(program, symtab, report);
+    if (opts.cfg) opt::simplify_cfg(program, symtab, report);
+    if (opts.peephole) opt::peephole(program, symtab, report);
+    if (opts.fuse_iinc || opts.fuse_if_icmp) opt::fuse(program, symtab, opts, report);
+    if (opts.locals) opt::coalesce_locals(program, symtab, report);
+    report.instrs_after = program.size();
+    LOG_DEBUG("optimizer: " << report.instrs_before << " -> " << report.instrs_after
+              << " instructions");
+}
+
+namespace opt {
+
+std::vector<uint8_t> boundaries(const std::vector<Instruction>& program,
+                                const SymbolTable& symtab) {
+    std::vector<uint8_t> b(program.size() + 1, 0);
+    for (const LabelInfo& li : symtab.labels()) {
+        if (li.defined) b[li.instr_index] = 1;
+    }
+    for (const auto& kv : symtab.methods()) {
+        const MethodInfo& mi = kv.second;
+        if (mi.first_instr != NO_INDEX) b[mi.first_instr] = 1;
+        if (mi.end_instr != NO_INDEX)   b[mi.end_instr] = 1;
+    }
+    return b;
+}
+
+std::vector<SymbolId> branch_targets(const std::vector<Instruction>& program,
+                                     const SymbolTable& symtab) {
+    std::vector<SymbolId> t(program.size(), NO_SYMBOL);
+    for (const Fixup& f : symtab.fixups()) {
+        if (f.kind == FixupKind::Label) t[f.instr_index] = f.target;
+    }
+    return t;
+}
+
+void compact(std::vector<Instruction>& program, SymbolTable& symtab,
+             const std::vector<uint8_t>& keep) {
+    std::vector<uint32_t> new_index(program.size() + 1);
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < program.size(); ++i) {
+        new_index[i] = static_cast<uint32_t>(out);
+        if (!keep[i]) continue;
+        if (out != i) program[out] = std::move(program[i]);
+        ++out;
+    }
+    new_index[program.size()] = static_cast<uint32_t>(out);
+    program.resize(out);
+    symtab.renumber(new_index);
+}
+
+} // namespace opt
+} // namespace assembler
@@ -4,24 +4,42 @@
 
 #include "assembler/Parser.hpp"
 #include "assembler/Utils.hpp" 
+#include "assembler/Stats.hpp"
+#include "assembler/Log.hpp"
+#include "assembler/Opcodes.hpp"
+#include "assembler/Layout.hpp"
+#include "assembler/Analysis.hpp"
 #include <cctype>
 #include <sstream>
 #include <iostream>
 #include <limits>
-#include <iostream> 
 #include <utility> // for std::move
+#include <string_view>
 
+// Token values are views into the source buffer; std::stoi wants a string.
+static int to_int(std::string_view s) {
+    return std::stoi(std::string(s));
+}
+
+
+Parser::Parser(TokenSource& src, assembler::Interner& names)
+    : src(src), tok(src.next()), idx(0), symtab(names), interner(names) {}
 
-Parser::Parser(const std::vector<Token>& t)
-    : toks(t), idx(0) {}
+// Id of an IDENT / LABEL_DEF token; interned here if the tokenizer did not.
+SymbolId Parser::sym_of(const Token& t) {
+    return t.sym != NO_SYMBOL ? t.sym : interner.intern(t.value);
+}
 
 const Token& Parser::cur() const {
-    if (idx < toks.size()) return toks[idx];
-    return toks.back();
+    return tok;
 }
 
+// The previous token's views may be invalidated by the pull, so anything
+// kept from it must already have been copied out.
 void Parser::advance() {
-    if (idx < toks.size()) ++idx;
+    if (tok.type == TokenType::END_OF_FILE) return;
+    tok = src.next();
+    ++idx;
 }
 
 bool Parser::accept(TokenType t) {
@@ -38,7 +56,7 @@ bool Parser::expect(TokenType t) {
     return false;
 }
 
-static bool is_number_literal(const std::string& s) {
+static bool is_number_literal(std::string_view s) {
     if (s.empty()) return false;
     size_t i = 0;
     if (s[0] == '+' || s[0] == '-') i = 1;
@@ -53,7 +71,7 @@ static bool is_number_literal(const std::string& s) {
 void Parser::parse_operands(Instruction &ins) {
     while (true) {
        if (cur().type == TokenType::NUMBER) {
-    int val = std::stoi(cur().value);
+    int val = to_int(cur().value);
     Operand op;
 
     // // Only PUSH goes through constant pool
@@ -63,8 +81,7 @@ void Parser::parse_operands(Instruction &ins) {
     //     op.pool_index = idx;
     // } else {
         // LOAD, STORE, etc. use immediate
-        op.kind = Operand::Kind::Immediate;
-        op.imm = val;
+        op = Operand::immediate(val);
     // }
 
     ins.operands.push_back(op);
@@ -77,13 +94,10 @@ void Parser::parse_operands(Instruction &ins) {
 
     if (is_number_literal(cur().value)) {
         // Directly store as immediate
-        int val = std::stoi(cur().value);
-        op.kind = Operand::Kind::Immediate;
-        op.imm = val;
+        op = Operand::immediate(to_int(cur().value));
     } else {
         // Treat as label for now, resolved later
-        op.kind = Operand::Kind::Label;
-        op.label = cur().value;
+        op = Operand::label(sym_of(cur()));
     }
 
     ins.operands.push_back(op);
@@ -111,191 +125,163 @@ void Parser::validate_instruction(const Instruction &ins) {
         errlist.push_back(os.str());
     };
 
-    switch (ins.op) {
-        // ---- One operand required ----
-        case OpCode::PUSH:
-        case OpCode::FPUSH:
-        case OpCode::LOAD:
-        case OpCode::STORE:
-        case OpCode::LOAD_ARG:
-        case OpCode::JMP:
-        case OpCode::JZ:
-        case OpCode::JNZ:
-        case OpCode::CALL:
-        case OpCode::NEW:
-        case OpCode::GETFIELD:
-        case OpCode::PUTFIELD:
-        case OpCode::INVOKEVIRTUAL:
-        case OpCode::INVOKESPECIAL:
-            if (ins.operands.size() != 1)
-                bad("Instruction requires exactly 1 operand");
-            break;
-
-        // ---- Zero operand instructions ----
-        case OpCode::POP: case OpCode::DUP:
-        case OpCode::FPOP:
-        // Int arithmetic
-        case OpCode::IADD: case OpCode::ISUB: case OpCode::IMUL:
-        case OpCode::IDIV: case OpCode::INEG:
-        // Float arithmetic
-        case OpCode::FADD: case OpCode::FSUB: case OpCode::FMUL:
-        case OpCode::FDIV: case OpCode::FNEG:
-        // Int comparisons
-        case OpCode::ICMP_EQ: case OpCode::ICMP_LT: case OpCode::ICMP_GT:
-        case OpCode::ICMP_GEQ: case OpCode::ICMP_NEQ: case OpCode::ICMP_LEQ:
-        // Float comparisons
-        case OpCode::FCMP_EQ: case OpCode::FCMP_LT: case OpCode::FCMP_GT:
-        case OpCode::FCMP_GEQ: case OpCode::FCMP_NEQ: case OpCode::FCMP_LEQ:
-        // Return
-        case OpCode::RET:
-            if (!ins.operands.empty())
-                bad("Instruction takes no operands");
-            break;
-
-        // ---- Catch invalid mnemonics ----
-        default:
-            if (ins.op == OpCode::INVALID)
-                bad("Invalid mnemonic");
-            break;
+    const assembler::OpcodeInfo& info = assembler::opcode_info(ins.op);
+    if (!info.valid()) {
+        bad("Invalid mnemonic");
+    } else if (ins.operands.size() != info.operand_count()) {
+        switch (info.operand_count()) {
+            case 0:  bad("Instruction takes no operands"); break;
+            case 1:  bad("Instruction requires exactly 1 operand"); break;
+            default: bad("Instruction requires exactly " +
+                         std::to_string(info.operand_count()) + " operands"); break;
+        }
     }
 }
 
 
 void Parser::parse_directive() {
-    std::string dir = cur().value; 
-    int line = cur().line, col = cur().col;
+    std::string dir(cur().value); 
+    Directive d = cur().dir;   // resolved by the tokenizer
+    int line = cur().line;
     advance();
-    if (dir == ".data") {
+    switch (d) {
+    case Directive::DATA:
         symtab.begin_data();
-    }
-    else if (dir == ".text") {
+        break;
+
+    case Directive::TEXT:
         symtab.begin_text();
-    }
-    else if (dir == ".word") {
+        break;
+
+    case Directive::WORD: {
         if (cur().type != TokenType::IDENT) {
             errlist.push_back("Expected label before .word at line " + std::to_string(line));
             return;
         }
-        std::string name = cur().value;
+        SymbolId name = sym_of(cur());
         advance();
 
         if (cur().type != TokenType::NUMBER) {
-            errlist.push_back("Expected numbers after .word " + name);
+            errlist.push_back("Expected numbers after .word " + std::string(interner.name(name)));
             return;
         }
 
         std::vector<int32_t> vals;
         while (cur().type == TokenType::NUMBER) {
-            vals.push_back(std::stoi(cur().value));
+            vals.push_back(to_int(cur().value));
             advance();
             if (cur().type == TokenType::COMMA) advance();
         }
 
         if (!symtab.define_data_symbol(name, vals)) {
-            errlist.push_back("Duplicate or invalid data symbol: " + name);
+            errlist.push_back("Duplicate or invalid data symbol: " + std::string(interner.name(name)));
         }
+        break;
     }
-        else if (dir == ".endclass") {
-            if (!symtab.end_class()) {
-                errlist.push_back("'.endclass' without active class at line " + std::to_string(line));
-            }
+
+    case Directive::ENDCLASS:
+        if (!symtab.end_class()) {
+            errlist.push_back("'.endclass' without active class at line " + std::to_string(line));
         }
-        else if (dir == ".endmethod") {
-            // uint32_t methodSize = symtab.lc() - methodStartOffset;
-            // symtab.set_method_size(methodName, methodSize);
+        break;
 
-            if (!symtab.end_method()) {
-                errlist.push_back("'.endmethod' without active method at line " + std::to_string(line));
-            }
+    case Directive::ENDMETHOD:
+        // uint32_t methodSize = symtab.lc() - methodStartOffset;
+        // symtab.set_method_size(methodName, methodSize);
+
+        if (!symtab.end_method()) {
+            errlist.push_back("'.endmethod' without active method at line " + std::to_string(line));
         }
+        break;
 
-    else  if (dir == ".class") {
+    case Directive::CLASS: {
         if (cur().type != TokenType::IDENT) {
             errlist.push_back("Expected class name after .class");
             return;
         }
-        std::string className = cur().value;
+        SymbolId className = sym_of(cur());
         if (!symtab.begin_class(className)) {
-            errlist.push_back("Duplicate or invalid class: " + className);
+            errlist.push_back("Duplicate or invalid class: " + std::string(interner.name(className)));
         }
         advance();
+        break;
     }
-    else if (dir == ".super") {
+
+    case Directive::SUPER: {
         if (cur().type != TokenType::IDENT) {
             errlist.push_back("Expected superclass name after .super");
             return;
         }
-        std::string superName = cur().value;
+        SymbolId superName = sym_of(cur());
         if (!symtab.set_super(superName)) {
-            errlist.push_back("Failed to set superclass: " + superName);
+            errlist.push_back("Failed to set superclass: " + std::string(interner.name(superName)));
         }
         advance();
+        break;
     }
-    else if (dir == ".field") {
+
+    case Directive::FIELD: {
         if (cur().type != TokenType::IDENT) {
             errlist.push_back("Expected field name after .field");
             return;
         }
-        std::string fieldName = cur().value;
+        SymbolId fieldName = sym_of(cur());
         advance();
         if (cur().type != TokenType::IDENT) {
             errlist.push_back("Expected field descriptor after field name");
             return;
         }
-        std::string descriptor = cur().value;
+        SymbolId descriptor = sym_of(cur());
         // pool_index unknown here, set to max()
         if (!symtab.add_field(symtab.current_class(), fieldName, descriptor,
                               std::numeric_limits<uint32_t>::max())) {
-            errlist.push_back("Duplicate field: " + fieldName);
+            errlist.push_back("Duplicate field: " + std::string(interner.name(fieldName)));
         }
         advance();
+        break;
     }
 
-else if (dir == ".method") {
-    if (cur().type != TokenType::IDENT) {
-        errlist.push_back("Expected method name after .method");
-        return;
-    }
+    case Directive::METHOD: {
+        if (cur().type != TokenType::IDENT) {
+            errlist.push_back("Expected method name after .method");
+            return;
+        }
 
-    std::string methodName = cur().value;
-    advance();
-    // if (cur().type != TokenType::IDENT) {
-    //     errlist.push_back("Expected method signature after method name");
-    //     return;
-    // }
-    // std::string signature = cur().value;
-    // advance();
-
-    // Use current_class_ if we are inside a class, else global method
-    auto owner = symtab.get_current_class();  // expose current_class_ via getter
-    
-
-    if (!symtab.begin_method(methodName, "")) {
-        std::string fullKey = owner.empty()
-            ? methodName 
-            : owner + "." + methodName ;
-        errlist.push_back("Duplicate method: " + fullKey);
-        return;
-    }
-    
+        SymbolId methodName = sym_of(cur());
+        advance();
+        // if (cur().type != TokenType::IDENT) {
+        //     errlist.push_back("Expected method signature after method name");
+        //     return;
+        // }
+        // std::string signature = cur().value;
+        // advance();
 
-    // --- Set method start address to current location counter ---
-    symtab.set_method_address(symtab.lc());
+        // Use current_class_ if we are inside a class, else global method
+        auto owner = symtab.get_current_class();  // expose current_class_ via getter
 
-}
+        if (!symtab.begin_method(methodName, "")) {
+            std::string fullKey = owner == NO_SYMBOL
+                ? std::string(interner.name(methodName))
+                : std::string(interner.name(owner)) + "." + std::string(interner.name(methodName));
+            errlist.push_back("Duplicate method: " + fullKey);
+            return;
+        }
 
-    else if (dir == ".limit") {
+        break;
+    }
+
+    case Directive::LIMIT: {
         if (cur().type != TokenType::IDENT) {
             errlist.push_back("Expected 'stack' or 'locals' after .limit");
             return;
         }
-        std::string kind = cur().value;
+        std::string kind(cur().value);
         advance();
         if (cur().type != TokenType::NUMBER) {
             errlist.push_back("Expected number after .limit " + kind);
             return;
         }
-        uint32_t val = std::stoi(cur().value);
+        uint32_t val = to_int(cur().value);
         if (kind == "stack") {
             if (!symtab.set_method_stack_limit(val))
                 errlist.push_back("Invalid .limit stack placement");
@@ -306,36 +292,41 @@ else if (dir == ".method") {
             errlist.push_back("Unknown limit kind: " + kind);
         }
         advance();
+        break;
     }
-   
-    else if (dir == ".end") {
+
+    case Directive::END:
         // end method or class depending on context
         if (!symtab.end_method()) {
             if (!symtab.end_class()) {
                 errlist.push_back("'.end' without active method or class");
             }
         }
-    }
-    else if (dir == ".const") {
+        break;
+
+    case Directive::CONST: {
         if (cur().type != TokenType::IDENT) {
             errlist.push_back("Expected constant name after .const");
             return;
         }
-        std::string constName = cur().value;
+        SymbolId constName = sym_of(cur());
         advance();
         if (cur().type != TokenType::NUMBER) {
             errlist.push_back("Expected value after constant name");
             return;
         }
-        int val = std::stoi(cur().value);
+        int val = to_int(cur().value);
         if (!symtab.define_constant(constName, val)) {
-            errlist.push_back("Duplicate constant: " + constName);
+            errlist.push_back("Duplicate constant: " + std::string(interner.name(constName)));
         }
         advance();
+        break;
     }
-    else {
+
+    case Directive::NONE:
         errlist.push_back("Unknown directive '" + dir + "' at line " +
                           std::to_string(line));
+        break;
     }
 }
 
@@ -356,11 +347,11 @@ void Parser::parse_line() {
     }
 
     if (cur().type == TokenType::LABEL_DEF) {
-        std::string lab = cur().value;
+        SymbolId lab = sym_of(cur());
         int l = cur().line, c = cur().col;
         if (!symtab.define_label(lab, l, c)) {
             std::ostringstream os;
-            os << "Duplicate label '" << lab << "' at " << l << ":" << c;
+            os << "Duplicate label '" << interner.name(lab) << "' at " << l << ":" << c;
             errlist.push_back(os.str());
         }
         advance();
@@ -368,8 +359,7 @@ void Parser::parse_line() {
     }
 
     if (cur().type == TokenType::MNEMONIC) {
-        std::string m = to_uppercopy(cur().value);
-        OpCode oc = mnemonic_to_opcode(m);
+        OpCode oc = cur().op;   // resolved by the tokenizer
 
         Instruction ins;
         ins.op = oc;
@@ -459,31 +449,26 @@ void Parser::parse_line() {
     if (cur().type != TokenType::IDENT) {
         errlist.push_back("Expected field reference after GETFIELD/PUTFIELD");
     } else {
-        std::string fullIdent = cur().value; 
+        // "ClassName.fieldName" is already the field's key
+        SymbolId key = sym_of(cur());
+        std::string_view fullIdent = interner.name(key);
         advance();
 
         // Split at '.' into class and field
         auto dotPos = fullIdent.find('.');
-        if (dotPos == std::string::npos) {
+        if (dotPos == std::string_view::npos) {
             errlist.push_back("Malformed field reference, need ClassName.fieldName");
         } else {
-            std::string clazz     = fullIdent.substr(0, dotPos);
-            std::string fieldName = fullIdent.substr(dotPos + 1);
-
-            // Build key for symbol table
-            std::string key = SymbolTable::make_field_key(clazz, fieldName);
-
             // Lookup or auto-register
             auto p= symtab.get_field(key);
             bool found = p.first;
             const FieldInfo& fieldInfo = p.second;
             if (!found) {
-                errlist.push_back("Undefined field reference: " + key);
+                errlist.push_back("Undefined field reference: " + std::string(fullIdent));
             }
 
             // Encode operand
-           op.kind = Operand::Kind::ConstPoolIndex;
-           op.pool_index = fieldInfo.pool_index;
+           op = Operand::constpool(fieldInfo.pool_index);
         }
     }
 
@@ -493,72 +478,25 @@ void Parser::parse_line() {
         else {
             parse_operands(ins);
 
-            // For jumps: record label references
+            // Jumps and calls: record label / method references; both are
+            // resolved in pass 2, once layout has fixed every address.
             if (ins.operands.size() == 1) {
-                switch (oc) {
-                    case OpCode::JMP:
-                    case OpCode::JZ:
-                    case OpCode::JNZ:
-                    {
-                        const Operand& op = ins.operands[0];
-                        if (op.kind == Operand::Kind::Label && !is_number_literal(op.label)) {
-                            symtab.add_label_reference(instrs.size(), 0, op.label,
-                                                      ins.src_line, ins.src_col);
-                        }
+                const assembler::OpcodeInfo& info = assembler::opcode_info(oc);
+                const Operand& op = ins.operands[0];
+                if (op.kind == Operand::Kind::Label && !is_number_literal(interner.name(op.sym))) {
+                    switch (info.operand) {
+                    case assembler::OperandType::Branch:
+                    case assembler::OperandType::RelBranch:
+                        symtab.add_fixup(instrs.size(), 0, op.sym, info.width,
+                                         ins.src_line, ins.src_col);
+                        break;
+                    case assembler::OperandType::Method:
+                        symtab.add_fixup(instrs.size(), 0, op.sym, info.width,
+                                         ins.src_line, ins.src_col, FixupKind::Method);
                         break;
-                    }
-                    case OpCode::INVOKESPECIAL:
-                    case OpCode::INVOKEVIRTUAL:
-                    {
-                    const Operand& op = ins.operands[0];
-                    if (op.kind == Operand::Kind::Label && !is_number_literal(op.label)) {
-                        std::cout<<"Method call to label: " << op.label << " at line " << ins.src_line << "\n";
-                        auto p= symtab.get_method(op.label);
-                        bool found = p.first;
-                        std::cout<<"Method found: " << found << "\n";
-                        const MethodInfo& methodInfo = p.second;
-                        if (found) {
-                            // Replace label operand with an immediate numeric one
-                            Operand newOp;
-                            newOp.kind = Operand::Kind::Immediate;
-                            //pu tin immediate
-                            newOp.imm = methodInfo.address;
-                            ins.operands[0] = newOp;
-                        } else {
-                            std::cerr << "Error: undefined method " << op.label
-                                    << " at line " << ins.src_line << "\n";
-                        }
-                    }
-                    break;
-                    }
-                     case OpCode::CALL:
-                    {
-       
-
-                    const Operand& op = ins.operands[0];
-                    if (op.kind == Operand::Kind::Label && !is_number_literal(op.label)) {
-                        std::cout<<"Method call to label: " << op.label << " at line " << ins.src_line << "\n";
-                        auto p= symtab.get_method(op.label);
-                        bool found = p.first;
-                        std::cout<<"Method found: " << found << "\n";
-                        const MethodInfo& methodInfo = p.second;
-                        if (found) {
-                            // Replace label operand with an immediate numeric one
-                            Operand newOp;
-                            newOp.kind = Operand::Kind::Immediate;
-                            //pu tin immediate
-                            newOp.imm = methodInfo.address;
-                            ins.operands[0] = newOp;
-                        } else {
-                            
-                            std::cerr << "Error: undefined method " << op.label
-                                    << " at line " << ins.src_line << "\n";
-                        }
-                    }
-                    break;
-                    }
                     default:
                         break;
+                    }
                 }
             }
         }
@@ -566,7 +504,7 @@ void Parser::parse_line() {
         validate_instruction(ins);
 
         instrs.push_back(std::move(ins));
-        symtab.advance_lc(instruction_size(instrs.back()));
+        symtab.advance_lc(assembler::encoded_size(instrs.back().op));
 
         return;
     }
@@ -577,61 +515,172 @@ void Parser::parse_line() {
     Main parse (single pass + resolve forward label refs)
 -----------------------------------------------------------------------------------------*/
 std::vector<Instruction> Parser::parse() {
-    idx = 0;
     instrs.clear();
     errlist.clear();
 
     uint32_t base = symtab.base();
-    symtab = SymbolTable(base);
+    symtab = SymbolTable(interner, base);
     symtab.reset_lc();
 
     // pass 1: read tokens into IR and collect labels/refs
-    while (cur().type != TokenType::END_OF_FILE) {
-        std::cout << "[DEBUG] idx=" << idx 
-                  << " token=" << cur().value 
-                  << " type=" << static_cast<int>(cur().type) << std::endl;
-
-        size_t old_idx = idx;
-        parse_line();
-        if (idx == old_idx) {
-            std::cerr << "[ERROR] idx did not advance, breaking to avoid infinite loop!" << std::endl;
-            break;
+    {
+        assembler::stats::Phase phase("parse");
+        while (cur().type != TokenType::END_OF_FILE) {
+            LOG_TRACE("idx=" << idx << " token=" << cur().value
+                      << " type=" << static_cast<int>(cur().type));
+
+            size_t old_idx = idx;
+            parse_line();
+            if (idx == old_idx) {
+                LOG_ERROR("idx did not advance, breaking to avoid infinite loop!");
+                break;
+            }
         }
     }
 
-    // pass 2: resolve pending label references
-    const auto& refs = symtab.pending_refs();
-    for (const auto& r : refs) {
-        if (r.instr_index >= instrs.size()) {
-            std::ostringstream os;
-            os << "Internal error: bad reference index " << r.instr_index;
-            errlist.push_back(os.str());
-            continue;
-        }
-        Instruction& target_ins = instrs[r.instr_index];
+    if (opts.any()) {
+        assembler::stats::Phase phase("optimize");
+        optrep = assembler::OptReport{};
+        assembler::optimize(instrs, symtab, opts, optrep);
+    }
 
-        auto found = symtab.get_label(r.label);
-        if (!found.first) {
-            std::ostringstream os;
-            os << "Undefined label '" << r.label << "' referenced at "
-               << r.line << ":" << r.col;
-            errlist.push_back(os.str());
-            continue;
-        }
-        uint32_t addr = found.second.address;
-        if (r.operand_index >= target_ins.operands.size()) {
-            std::ostringstream os;
-            os << "Internal error: operand index OOB on '" << r.label << "'";
-            errlist.push_back(os.str());
-            continue;
+    check_frame_limits();
+
+    // layout: pick jump forms, then move labels and methods to match
+    if (relax) {
+        assembler::stats::Phase phase("layout");
+        assembler::RelaxReport lay = assembler::relax_branches(instrs, symtab);
+        symtab.relocate(lay.offsets);
+        LOG_DEBUG("branch relaxation: " << lay.passes << " passes, "
+                  << lay.rel8 << " rel8, " << lay.abs16 << " abs16, "
+                  << lay.abs32 << " abs32, " << lay.rel16 << " rel16 jumps");
+        assembler::stats::count("relax_passes", lay.passes);
+        assembler::stats::count("jumps_rel8", lay.rel8);
+        assembler::stats::count("jumps_abs16", lay.abs16);
+        assembler::stats::count("jumps_abs32", lay.abs32);
+        assembler::stats::count("jumps_rel16", lay.rel16);
+    } else if (opts.any()) {
+        symtab.relocate(assembler::layout_offsets(instrs));
+    }
+
+    // pass 2: resolve label and method fixups to what their slots encode
+    {
+        assembler::stats::Phase phase("fixups");
+        const auto& refs = symtab.fixups();
+        for (size_t k = 0; k < refs.size(); ++k) {
+            const Fixup& r = refs[k];
+            if (r.instr_index >= instrs.size()) {
+                std::ostringstream os;
+                os << "Internal error: bad reference index " << r.instr_index;
+                errlist.push_back(os.str());
+                continue;
+            }
+            Instruction& target_ins = instrs[r.instr_index];
+            if (r.operand_index >= target_ins.operands.size()) {
+                std::ostringstream os;
+                os << "Internal error: operand index OOB on '" << interner.name(r.target) << "'";
+                errlist.push_back(os.str());
+                continue;
+            }
+            const assembler::OpcodeInfo& info = assembler::opcode_info(target_ins.op);
+
+            if (r.kind == FixupKind::Method) {
+                auto m = symtab.get_method(r.target);
+                LOG_DEBUG("method call to " << interner.name(r.target) << " at line " << r.line
+                          << (m.first ? "" : " (unresolved)"));
+                if (!m.first) {
+                    LOG_ERROR("undefined method " << interner.name(r.target)
+                              << " at line " << r.line);
+                    continue;
+                }
+                symtab.resolve_fixup(k, m.second.address, info.width);
+                continue;
+            }
+
+            auto found = symtab.get_label(r.target);
+            if (!found.first) {
+                std::ostringstream os;
+                os << "Undefined label '" << interner.name(r.target) << "' referenced at "
+                   << r.line << ":" << r.col;
+                errlist.push_back(os.str());
+                continue;
+            }
+            uint32_t addr = found.second.address;
+            int64_t next = (int64_t)base + r.from_code_offset + info.size();
+            uint32_t value = info.operand == assembler::OperandType::RelBranch
+                           ? static_cast<uint32_t>((int64_t)addr - next) : addr;
+            if (!assembler::reaches(target_ins.op, addr, next)) {
+                std::ostringstream os;
+                os << "Jump to '" << interner.name(r.target) << "' at " << r.line << ":"
+                   << r.col << " cannot reach address " << addr << " with "
+                   << info.mnemonic;
+                errlist.push_back(os.str());
+                continue;
+            }
+            symtab.resolve_fixup(k, value, info.width);
         }
-        target_ins.operands[r.operand_index].label = std::to_string(addr);
     }
 
     return instrs;
 }
 
 
+// Checks each method's .limit stack and .limit locals against what its
+// code needs. A missing limit is filled in, and one below what is needed
+// is raised to it with a warning; a larger one is kept and only logged at
+// info level. The stack limit is skipped for methods with underflows,
+// inconsistent depths, calls of unknown arity or branches the analysis
+// cannot follow.
+void Parser::check_frame_limits() {
+    assembler::stats::Phase phase("frame_limits");
+    for (const auto& kv : symtab.methods()) {
+        const MethodInfo& mi = kv.second;
+        uint32_t used = assembler::locals_used(instrs, mi);
+        if (mi.first_instr == NO_INDEX || used == NO_INDEX) continue;
+        std::string_view name = interner.name(kv.first);
+        if (!mi.has_locals_limit) {
+            symtab.set_locals_limit(kv.first, used);
+            assembler::stats::count("locals_limits_computed", 1);
+        } else if (mi.locals_limit < used) {
+            LOG_WARN("method " << name << " declares .limit locals " << mi.locals_limit
+                     << " but uses " << used << "; using " << used);
+            symtab.set_locals_limit(kv.first, used);
+        } else if (mi.locals_limit > used) {
+            LOG_INFO("method " << name << " declares .limit locals " << mi.locals_limit
+                     << ", uses only " << used);
+        }
+    }
+
+    for (const assembler::StackReport& r : assembler::analyze_stack(instrs, symtab)) {
+        std::string_view name = interner.name(r.method);
+        if (!r.known) {
+            LOG_DEBUG("method " << name << ": stack depth unknown (call of unknown arity"
+                      " or a branch out of the method)");
+            continue;
+        }
+        // A broken method can have thousands; the first few tell the story.
+        for (std::size_t k = 0; k < r.problems.size() && k < 5; ++k)
+            LOG_WARN("method " << name << ": " << r.problems[k]);
+        if (r.problems.size() > 5)
+            LOG_WARN("method " << name << ": " << r.problems.size() - 5 << " more stack problems");
+        if (!r.problems.empty()) continue;   // the depth is not trustworthy
+        const MethodInfo& mi = symtab.get_method(r.method).second;
+        LOG_DEBUG("method " << name << ": max stack " << r.max_depth);
+        if (!mi.has_stack_limit) {
+            symtab.set_stack_limit(r.method, r.max_depth);
+            assembler::stats::count("stack_limits_computed", 1);
+        } else if (mi.stack_limit < r.max_depth) {
+            // Too small a frame overflows in the VM
+            LOG_WARN("method " << name << " declares .limit stack " << mi.stack_limit
+                     << " but needs " << r.max_depth << "; using " << r.max_depth);
+            symtab.set_stack_limit(r.method, r.max_depth);
+        } else if (mi.stack_limit > r.max_depth) {
+            LOG_INFO("method " << name << " declares .limit stack " << mi.stack_limit
+                     << ", needs only " << r.max_depth);
+        }
+    }
+}
+
 const std::vector<std::string>& Parser::errors() const {
     return errlist;
 }
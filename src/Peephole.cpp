@@ -0,0 +1,126 @@
+// ============================================================================
+// Peephole.cpp - table-driven peephole rewrites (-O)
+// ============================================================================
+#include "assembler/Optimizer.hpp"
+
+namespace assembler {
+namespace opt {
+
+namespace {
+
+enum class Guard : uint8_t {
+    None,
+    SkipsWindow,    // match[0] jumps to the instruction right after the match
+};
+
+enum class Rewrite : uint8_t {
+    Keep,           // kept instructions stay as they are
+    InvertFirst,    // first kept instruction becomes match[0] with its test inverted
+};
+
+// When `match` occurs with no label or method boundary inside it (its
+// first instruction may carry one) and `guard` holds, it is replaced by the
+// instructions at `keep`, which index into the match in increasing order.
+// Rewrites only ever drop instructions, so labels stay attached by
+// compact().
+struct Pattern {
+    const char* name;
+    uint8_t     length;
+    OpCode      match[5];
+    uint8_t     kept;
+    uint8_t     keep[4];
+    Guard       guard;
+    Rewrite     rewrite;
+};
+
+using O = OpCode;
+
+constexpr Pattern PATTERNS[] = {
+    // LOAD n; DUP; PUSH k; IADD; STORE n; POP: a post-increment whose old
+    // value is discarded, so the DUP/POP pair is dead.
+    {"dead-dup-pop", 5, {O::DUP, O::PUSH, O::IADD, O::STORE, O::POP}, 3, {1, 2, 3},
+     Guard::None, Rewrite::Keep},
+    {"dead-dup-pop", 5, {O::DUP, O::PUSH, O::ISUB, O::STORE, O::POP}, 3, {1, 2, 3},
+     Guard::None, Rewrite::Keep},
+
+    // JNZ L0; JMP L1; L0:  ->  JZ L1
+    {"branch-over-jump", 2, {O::JNZ, O::JMP}, 1, {1}, Guard::SkipsWindow, Rewrite::InvertFirst},
+    {"branch-over-jump", 2, {O::JZ, O::JMP},  1, {1}, Guard::SkipsWindow, Rewrite::InvertFirst},
+
+    // JMP L; L:
+    {"jump-to-next", 1, {O::JMP}, 0, {}, Guard::SkipsWindow, Rewrite::Keep},
+
+    // A value pushed without side effects and popped straight away.
+    {"push-pop", 2, {O::PUSH, O::POP},      0, {}, Guard::None, Rewrite::Keep},
+    {"push-pop", 2, {O::FPUSH, O::FPOP},    0, {}, Guard::None, Rewrite::Keep},
+    {"push-pop", 2, {O::LOAD, O::POP},      0, {}, Guard::None, Rewrite::Keep},
+    {"push-pop", 2, {O::LOAD_ARG, O::POP},  0, {}, Guard::None, Rewrite::Keep},
+    {"push-pop", 2, {O::DUP, O::POP},       0, {}, Guard::None, Rewrite::Keep},
+};
+
+OpCode inverted(OpCode op) {
+    switch (op) {
+        case OpCode::JZ:  return OpCode::JNZ;
+        case OpCode::JNZ: return OpCode::JZ;
+        default:          return OpCode::INVALID;
+    }
+}
+
+bool matches(const Pattern& p, const std::vector<Instruction>& program, std::size_t i,
+             const std::vector<uint8_t>& boundary, const std::vector<SymbolId>& target,
+             const SymbolTable& symtab) {
+    if (i + p.length > program.size()) return false;
+    for (std::size_t k = 0; k < p.length; ++k) {
+        if (program[i + k].op != p.match[k]) return false;
+        if (k > 0 && boundary[i + k]) return false;
+    }
+    if (p.guard == Guard::SkipsWindow) {
+        auto label = symtab.get_label(target[i]);
+        if (!label.first || label.second.instr_index != i + p.length) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::size_t peephole(std::vector<Instruction>& program, SymbolTable& symtab,
+                     OptReport& report) {
+    std::size_t total = 0;
+    // A rewrite can expose another (PUSH; DUP; POP; POP), so repeat to a
+    // fixed point; every pass that rewrites also shrinks the program.
+    for (;;) {
+        std::vector<uint8_t> boundary = boundaries(program, symtab);
+        std::vector<SymbolId> target = branch_targets(program, symtab);
+        std::vector<uint8_t> keep(program.size(), 1);
+        std::size_t rewrites = 0;
+
+        for (std::size_t i = 0; i < program.size();) {
+            const Pattern* hit = nullptr;
+            for (const Pattern& p : PATTERNS) {
+                if (matches(p, program, i, boundary, target, symtab)) {
+                    hit = &p;
+                    break;
+                }
+            }
+            if (!hit) {
+                ++i;
+                continue;
+            }
+            for (std::size_t k = 0; k < hit->length; ++k) keep[i + k] = 0;
+            for (std::size_t k = 0; k < hit->kept; ++k) keep[i + hit->keep[k]] = 1;
+            if (hit->rewrite == Rewrite::InvertFirst)
+                program[i + hit->keep[0]].op = inverted(program[i].op);
+            report.hit(hit->name);
+            ++rewrites;
+            i += hit->length;
+        }
+
+        if (rewrites == 0) break;
+        compact(program, symtab, keep);
+        total += rewrites;
+    }
+    return total;
+}
+
+} // namespace opt
+} // namespace assembler
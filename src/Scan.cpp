@@ -0,0 +1,210 @@
+// ============================================================================
+// Scan.cpp - SSE2 / AVX2 / scalar whitespace and newline scanners
+// ============================================================================
+#include "assembler/Scan.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && defined(__SSE2__)
+#define ASSEMBLER_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace assembler {
+namespace scan {
+
+// ---------------------------------------------------------------------------
+// Scalar reference versions (also used for the tails of the vector loops)
+// ---------------------------------------------------------------------------
+
+static SpaceRun skip_space_scalar(const char* s, std::size_t pos, std::size_t n,
+                                  SpaceRun r) {
+    while (pos < n && is_space(s[pos])) {
+        if (s[pos] == '\n') {
+            ++r.newlines;
+            r.last_newline = pos;
+        }
+        ++pos;
+    }
+    r.end = pos;
+    return r;
+}
+
+static SpaceRun skip_space_scalar(const char* s, std::size_t pos, std::size_t n) {
+    return skip_space_scalar(s, pos, n, SpaceRun{pos, 0, 0});
+}
+
+static std::size_t find_newline_scalar(const char* s, std::size_t pos, std::size_t n) {
+    while (pos < n && s[pos] != '\n') ++pos;
+    return pos;
+}
+
+#ifdef ASSEMBLER_SCAN_X86
+
+static inline unsigned ctz32(unsigned v) { return (unsigned)__builtin_ctz(v); }
+static inline unsigned msb32(unsigned v) { return 31u - (unsigned)__builtin_clz(v); }
+static inline unsigned popcnt32(unsigned v) { return (unsigned)__builtin_popcount(v); }
+
+// Folds the newline bits of one block starting at `base` into the run.
+static inline void count_newlines(SpaceRun& r, unsigned nl, std::size_t base) {
+    if (nl) {
+        r.newlines += popcnt32(nl);
+        r.last_newline = base + msb32(nl);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// SSE2: 16 bytes per step
+// ---------------------------------------------------------------------------
+
+static SpaceRun skip_space_sse2(const char* s, std::size_t pos, std::size_t n) {
+    const __m128i sp   = _mm_set1_epi8(' ');
+    const __m128i nlc  = _mm_set1_epi8('\n');
+    const __m128i tab  = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8('\r' - '\t');
+
+    SpaceRun r{pos, 0, 0};
+    while (pos + 16 <= n) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pos));
+        // (v - '\t') <= 4 unsigned  <=>  v in ['\t', '\r']
+        __m128i d  = _mm_sub_epi8(v, tab);
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, sp),
+                                  _mm_cmpeq_epi8(_mm_min_epu8(d, four), d));
+        unsigned space = (unsigned)_mm_movemask_epi8(ws);
+        unsigned nl    = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nlc));
+        if (space != 0xFFFFu) {
+            unsigned stop = ctz32(~space);
+            count_newlines(r, nl & ((1u << stop) - 1u), pos);
+            r.end = pos + stop;
+            return r;
+        }
+        count_newlines(r, nl, pos);
+        pos += 16;
+    }
+    return skip_space_scalar(s, pos, n, r);
+}
+
+static std::size_t find_newline_sse2(const char* s, std::size_t pos, std::size_t n) {
+    const __m128i nlc = _mm_set1_epi8('\n');
+    while (pos + 16 <= n) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pos));
+        unsigned nl = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nlc));
+        if (nl) return pos + ctz32(nl);
+        pos += 16;
+    }
+    return find_newline_scalar(s, pos, n);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2: 32 bytes per step, only called when the CPU reports AVX2
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static SpaceRun skip_space_avx2(const char* s, std::size_t pos, std::size_t n) {
+    const __m256i sp   = _mm256_set1_epi8(' ');
+    const __m256i nlc  = _mm256_set1_epi8('\n');
+    const __m256i tab  = _mm256_set1_epi8('\t');
+    const __m256i four = _mm256_set1_epi8('\r' - '\t');
+
+    SpaceRun r{pos, 0, 0};
+    while (pos + 32 <= n) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pos));
+        __m256i d  = _mm256_sub_epi8(v, tab);
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, sp),
+                                     _mm256_cmpeq_epi8(_mm256_min_epu8(d, four), d));
+        unsigned space = (unsigned)_mm256_movemask_epi8(ws);
+        unsigned nl    = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nlc));
+        if (space != 0xFFFFFFFFu) {
+            unsigned stop = ctz32(~space);
+            count_newlines(r, stop ? nl & (0xFFFFFFFFu >> (32 - stop)) : 0u, pos);
+            r.end = pos + stop;
+            return r;
+        }
+        count_newlines(r, nl, pos);
+        pos += 32;
+    }
+    return skip_space_scalar(s, pos, n, r);
+}
+
+__attribute__((target("avx2")))
+static std::size_t find_newline_avx2(const char* s, std::size_t pos, std::size_t n) {
+    const __m256i nlc = _mm256_set1_epi8('\n');
+    while (pos + 32 <= n) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pos));
+        unsigned nl = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nlc));
+        if (nl) return pos + ctz32(nl);
+        pos += 32;
+    }
+    return find_newline_scalar(s, pos, n);
+}
+
+#endif // ASSEMBLER_SCAN_X86
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct Dispatch {
+    Isa isa;
+    SpaceRun    (*skip_space)(const char*, std::size_t, std::size_t);
+    std::size_t (*find_newline)(const char*, std::size_t, std::size_t);
+};
+
+Dispatch make_dispatch(Isa isa) {
+    switch (isa) {
+#ifdef ASSEMBLER_SCAN_X86
+        case Isa::AVX2: return {Isa::AVX2, skip_space_avx2, find_newline_avx2};
+        case Isa::SSE2: return {Isa::SSE2, skip_space_sse2, find_newline_sse2};
+#endif
+        default:        return {Isa::Scalar, skip_space_scalar, find_newline_scalar};
+    }
+}
+
+Isa best_isa() {
+#ifdef ASSEMBLER_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+    return Isa::SSE2;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+Dispatch& dispatch() {
+    static Dispatch d = make_dispatch(best_isa());
+    return d;
+}
+
+} // namespace
+
+Isa active_isa() { return dispatch().isa; }
+
+bool isa_supported(Isa isa) {
+    return static_cast<int>(isa) <= static_cast<int>(best_isa());
+}
+
+bool set_isa(Isa isa) {
+    if (!isa_supported(isa)) return false;
+    dispatch() = make_dispatch(isa);
+    return true;
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2:   return "sse2";
+        case Isa::AVX2:   return "avx2";
+    }
+    return "unknown";
+}
+
+SpaceRun skip_space(const char* s, std::size_t pos, std::size_t n) {
+    return dispatch().skip_space(s, pos, n);
+}
+
+std::size_t find_newline(const char* s, std::size_t pos, std::size_t n) {
+    return dispatch().find_newline(s, pos, n);
+}
+
+} // namespace scan
+} // namespace assembler
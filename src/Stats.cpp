@@ -0,0 +1,186 @@
+// ============================================================================
+// Stats.cpp - per-phase timing, counters and heap allocation tracking
+// ============================================================================
+#include "assembler/Stats.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <new>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define ASSEMBLER_STATS_USABLE_SIZE 1
+#endif
+
+namespace assembler {
+namespace stats {
+
+namespace {
+
+std::atomic<bool>     g_enabled{false};
+std::atomic<uint64_t> g_allocs{0};
+std::atomic<uint64_t> g_bytes{0};
+std::atomic<int64_t>  g_live{0};     // may go negative: frees of early allocations
+std::atomic<int64_t>  g_peak{0};     // max of g_live since the current phase began
+
+// Function-local so they exist before any phase or counter is recorded,
+// whatever the static initialization order.
+std::vector<PhaseReport>& phase_list() {
+    static std::vector<PhaseReport> v;
+    return v;
+}
+
+std::map<std::string, uint64_t>& counter_map() {
+    static std::map<std::string, uint64_t> m;
+    return m;
+}
+
+double wall_now_ms() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+double cpu_now_ms() {
+    return 1000.0 * (double)std::clock() / CLOCKS_PER_SEC;
+}
+
+void note_alloc(void* p, std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(n, std::memory_order_relaxed);
+#ifdef ASSEMBLER_STATS_USABLE_SIZE
+    int64_t size = (int64_t)malloc_usable_size(p);
+    int64_t live = g_live.fetch_add(size, std::memory_order_relaxed) + size;
+    int64_t peak = g_peak.load(std::memory_order_relaxed);
+    while (live > peak &&
+           !g_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+#else
+    (void)p;
+#endif
+}
+
+void note_free(void* p) {
+#ifdef ASSEMBLER_STATS_USABLE_SIZE
+    g_live.fetch_sub((int64_t)malloc_usable_size(p), std::memory_order_relaxed);
+#else
+    (void)p;
+#endif
+}
+
+void write_string(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void enable() { g_enabled.store(true, std::memory_order_relaxed); }
+bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+Phase::Phase(const char* name)
+    : name_(name), active_(enabled()), wall0_(0), cpu0_(0),
+      allocs0_(0), bytes0_(0), live0_(0) {
+    if (!active_) return;
+    allocs0_ = g_allocs.load(std::memory_order_relaxed);
+    bytes0_  = g_bytes.load(std::memory_order_relaxed);
+    live0_   = g_live.load(std::memory_order_relaxed);
+    g_peak.store(live0_, std::memory_order_relaxed);
+    cpu0_  = cpu_now_ms();
+    wall0_ = wall_now_ms();
+}
+
+Phase::~Phase() {
+    if (!active_) return;
+    double wall1 = wall_now_ms();
+    double cpu1  = cpu_now_ms();
+    PhaseReport r;
+    r.name        = name_;
+    r.wall_ms     = wall1 - wall0_;
+    r.cpu_ms      = cpu1 - cpu0_;
+    r.allocs      = g_allocs.load(std::memory_order_relaxed) - allocs0_;
+    r.alloc_bytes = g_bytes.load(std::memory_order_relaxed) - bytes0_;
+    int64_t peak  = g_peak.load(std::memory_order_relaxed) - live0_;
+    r.peak_bytes  = peak > 0 ? (uint64_t)peak : 0;
+    phase_list().push_back(r);
+}
+
+void count(const char* name, uint64_t value) {
+    if (!enabled()) return;
+    counter_map()[name] = value;
+}
+
+const std::vector<PhaseReport>& phases() { return phase_list(); }
+
+void write_json(std::ostream& out) {
+    out << "{\n  \"phases\": [";
+    const auto& ps = phase_list();
+    for (std::size_t i = 0; i < ps.size(); ++i) {
+        const auto& p = ps[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": ";
+        write_string(out, p.name);
+        out << ", \"wall_ms\": " << p.wall_ms
+            << ", \"cpu_ms\": " << p.cpu_ms
+            << ", \"allocs\": " << p.allocs
+            << ", \"alloc_bytes\": " << p.alloc_bytes
+            << ", \"peak_bytes\": " << p.peak_bytes << "}";
+    }
+    out << "\n  ],\n  \"counters\": {";
+    bool first = true;
+    for (const auto& kv : counter_map()) {
+        out << (first ? "\n" : ",\n") << "    ";
+        write_string(out, kv.first);
+        out << ": " << kv.second;
+        first = false;
+    }
+    out << "\n  },\n  \"heap\": {\"allocs\": " << g_allocs.load()
+        << ", \"alloc_bytes\": " << g_bytes.load()
+#ifdef ASSEMBLER_STATS_USABLE_SIZE
+        << ", \"peak_tracking\": true"
+#else
+        << ", \"peak_tracking\": false"
+#endif
+        << "}\n}\n";
+}
+
+} // namespace stats
+} // namespace assembler
+
+// ---------------------------------------------------------------------------
+// Global allocation hooks. They defer to malloc/free and only count while
+// stats are enabled.
+// ---------------------------------------------------------------------------
+
+using assembler::stats::enabled;
+
+static void* counted_alloc(std::size_t n) {
+    void* p = std::malloc(n ? n : 1);
+    if (p && enabled()) assembler::stats::note_alloc(p, n);
+    return p;
+}
+
+static void counted_free(void* p) {
+    if (!p) return;
+    if (enabled()) assembler::stats::note_free(p);
+    std::free(p);
+}
+
+void* operator new(std::size_t n) {
+    if (void* p = counted_alloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {
+    if (void* p = counted_alloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return counted_alloc(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return counted_alloc(n); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
@@ -0,0 +1,103 @@
+// ============================================================================
+// StringTable.cpp - deduplicated, suffix-shared string table
+// ============================================================================
+#include "assembler/StringTable.hpp"
+#include <algorithm>
+
+namespace assembler {
+
+namespace {
+
+uint32_t hash_bytes(std::string_view s) {
+    uint64_t h = 14695981039346656037ull;               // FNV-1a
+    for (unsigned char c : s) h = (h ^ c) * 1099511628211ull;
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+// The last (up to) eight bytes, last byte most significant: comparing two
+// keys compares the strings' reversed bytes, as far as the keys reach.
+uint64_t suffix_key(std::string_view s) {
+    uint64_t k = 0;
+    std::size_t n = std::min<std::size_t>(s.size(), 8);
+    for (std::size_t i = 0; i < n; ++i)
+        k |= uint64_t(static_cast<unsigned char>(s[s.size() - 1 - i])) << (56 - 8 * i);
+    return k;
+}
+
+bool ends_with(std::string_view s, std::string_view tail) {
+    return s.size() >= tail.size() && s.compare(s.size() - tail.size(), tail.size(), tail) == 0;
+}
+
+} // namespace
+
+std::size_t StringTable::find_slot(std::string_view s, uint32_t h) const {
+    std::size_t mask = slots_.size() - 1;
+    std::size_t i = h & mask;
+    for (; slots_[i].id; i = (i + 1) & mask)
+        if (slots_[i].hash == h && strings_[slots_[i].id - 1] == s) break;
+    return i;
+}
+
+void StringTable::grow() {
+    std::vector<Slot> slots(slots_.empty() ? 64 : slots_.size() * 2, Slot{0, 0});
+    std::size_t mask = slots.size() - 1;
+    for (const Slot& s : slots_) {
+        if (!s.id) continue;
+        std::size_t i = s.hash & mask;
+        while (slots[i].id) i = (i + 1) & mask;
+        slots[i] = s;
+    }
+    slots_.swap(slots);
+}
+
+void StringTable::add(std::string_view s) {
+    if ((strings_.size() + 1) * 2 > slots_.size()) grow();   // load <= 1/2
+    uint32_t h = hash_bytes(s);
+    std::size_t i = find_slot(s, h);
+    if (slots_[i].id) return;
+    strings_.push_back(s);
+    slots_[i] = Slot{static_cast<uint32_t>(strings_.size()), h};
+}
+
+void StringTable::finish() {
+    // Sorted by reversed bytes, every string comes right before the
+    // strings it is a suffix of, so walking backwards meets each one just
+    // after a string that contains it, if any does.
+    struct Item {
+        uint64_t key;
+        uint32_t id;
+    };
+    std::vector<Item> order(strings_.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = Item{suffix_key(strings_[i]), i};
+    std::sort(order.begin(), order.end(), [&](const Item& a, const Item& b) {
+        if (a.key != b.key) return a.key < b.key;
+        std::string_view x = strings_[a.id], y = strings_[b.id];
+        return std::lexicographical_compare(x.rbegin(), x.rend(), y.rbegin(), y.rend());
+    });
+
+    // The layout depends only on the set of strings, not on the order they
+    // were added in, so the same program always gives the same table.
+    offsets_.assign(strings_.size(), 0);
+    data_.clear();
+    std::string_view prev;
+    uint32_t prev_offset = 0;
+    for (std::size_t k = order.size(); k-- > 0;) {
+        uint32_t id = order[k].id;
+        std::string_view s = strings_[id];
+        if (k + 1 < order.size() && ends_with(prev, s)) {
+            offsets_[id] = prev_offset + static_cast<uint32_t>(prev.size() - s.size());
+            continue;
+        }
+        prev = s;
+        prev_offset = static_cast<uint32_t>(data_.size());
+        offsets_[id] = prev_offset;
+        data_.append(s.data(), s.size());
+        data_.push_back('\0');
+    }
+}
+
+uint32_t StringTable::offset(std::string_view s) const {
+    return offsets_[slots_[find_slot(s, hash_bytes(s))].id - 1];
+}
+
+} // namespace assembler
@@ -3,52 +3,91 @@
 // ============================================================================
 
 #include "assembler/SymbolTable.hpp"
+#include "assembler/Log.hpp"
 #include <limits>
-#include <iostream>
 
 // ----- Labels -----
 
-bool SymbolTable::define_label(const std::string& name, int line, int col) {
-    if (labels_.find(name) != labels_.end()) {
+bool SymbolTable::define_label(SymbolId name, int line, int col) {
+    if (name >= labels_.size()) labels_.resize(name + 1);
+    LabelInfo& li = labels_[name];
+    if (li.defined) {
         return false; // duplicate
     }
-    LabelInfo li;
     li.address = base_address_ + lc_bytes_; // absolute byte address at definition
+    li.instr_index = instr_count_;
     li.line = line;
     li.col  = col;
-    labels_[name] = li;
+    li.defined = true;
+    ++label_count_;
     return true;
 }
 
-std::pair<bool, LabelInfo> SymbolTable::get_label(const std::string& name) const {
-    auto it = labels_.find(name);
-    if (it == labels_.end()) return {false, LabelInfo{}};
-    return {true, it->second};
+std::pair<bool, LabelInfo> SymbolTable::get_label(SymbolId name) const {
+    if (name >= labels_.size() || !labels_[name].defined) return {false, LabelInfo{}};
+    return {true, labels_[name]};
+}
+
+void SymbolTable::add_fixup(std::size_t instr_index,
+                            std::size_t operand_index,
+                            SymbolId target, uint8_t width,
+                            int line, int col,
+                            FixupKind kind) {
+    Fixup f;
+    f.instr_index = instr_index;
+    f.operand_index = operand_index;
+    f.target = target;
+    f.kind = kind;
+    f.width = width;
+    f.line = line;
+    f.col  = col;
+    f.from_code_offset = lc_bytes_; // snapshot of LC when reference recorded (debug)
+    fixups_.push_back(f);
 }
 
-void SymbolTable::add_label_reference(std::size_t instr_index,
-                                      std::size_t operand_index,
-                                      const std::string& label,
-                                      int line, int col) {
-    PendingRef pr;
-    pr.instr_index = instr_index;
-    pr.operand_index = operand_index;
-    pr.label = label;
-    pr.line = line;
-    pr.col  = col;
-    pr.from_code_offset = lc_bytes_; // snapshot of LC when reference recorded (debug)
-    pending_refs_.push_back(pr);
+void SymbolTable::relocate(const std::vector<uint32_t>& offsets) {
+    for (LabelInfo& li : labels_) {
+        if (li.defined) li.address = base_address_ + offsets[li.instr_index];
+    }
+    for (auto& kv : methods_) {
+        MethodInfo& mi = kv.second;
+        if (mi.first_instr == NO_INDEX) continue;
+        mi.address = base_address_ + offsets[mi.first_instr];
+        if (mi.end_instr != NO_INDEX)
+            mi.size = offsets[mi.end_instr] - offsets[mi.first_instr];
+    }
+    for (Fixup& f : fixups_) {
+        f.from_code_offset = offsets[f.instr_index];
+    }
+    lc_bytes_ = offsets.back();
+}
+
+void SymbolTable::renumber(const std::vector<uint32_t>& new_index) {
+    for (LabelInfo& li : labels_) {
+        if (li.defined) li.instr_index = new_index[li.instr_index];
+    }
+    for (auto& kv : methods_) {
+        MethodInfo& mi = kv.second;
+        if (mi.first_instr != NO_INDEX) mi.first_instr = new_index[mi.first_instr];
+        if (mi.end_instr != NO_INDEX)   mi.end_instr = new_index[mi.end_instr];
+    }
+    std::size_t out = 0;
+    for (Fixup& f : fixups_) {
+        if (new_index[f.instr_index] == new_index[f.instr_index + 1]) continue;
+        f.instr_index = new_index[f.instr_index];
+        fixups_[out++] = f;
+    }
+    fixups_.resize(out);
+    instr_count_ = new_index.back();
 }
 
 // ----- Constants (.const) -----
 
-bool SymbolTable::define_constant(const std::string& name, int32_t value) {
-    if (constants_.find(name) != constants_.end()) return false;
-    constants_[name] = ConstantInfo{name, value};
-    return true;
+bool SymbolTable::define_constant(SymbolId name, int32_t value) {
+    return constants_.emplace(name, ConstantInfo{name, value}).second;
 }
 
-std::pair<bool, ConstantInfo> SymbolTable::get_constant(const std::string& name) const {
+std::pair<bool, ConstantInfo> SymbolTable::get_constant(SymbolId name) const {
     auto it = constants_.find(name);
     if (it == constants_.end()) return {false, ConstantInfo{}};
     return {true, it->second};
@@ -56,42 +95,42 @@ std::pair<bool, ConstantInfo> SymbolTable::get_constant(const std::string& name)
 
 // ----- Classes (.class / .super / fields) -----
 
-bool SymbolTable::begin_class(const std::string& class_name) {
+// The class record for `class_name`, created empty if it does not exist.
+ClassInfo& SymbolTable::class_entry(SymbolId class_name) {
+    auto cit = classes_.find(class_name);
+    if (cit == classes_.end()) {
+        ClassInfo ci;
+        ci.name = class_name;
+        ci.pool_index = std::numeric_limits<uint32_t>::max();
+        cit = classes_.emplace(class_name, ci).first;
+    }
+    return cit->second;
+}
+
+bool SymbolTable::begin_class(SymbolId class_name) {
     if (classes_.find(class_name) != classes_.end()) {
         return false;
     }
-    ClassInfo ci;
-    ci.name = class_name;
-    ci.super_name = "";
-    ci.pool_index = std::numeric_limits<uint32_t>::max();
-    classes_[class_name] = ci;
+    class_entry(class_name);
     current_class_ = class_name;
     return true;
 }
 
-bool SymbolTable::set_super(const std::string& super_name) {
-    if (current_class_.empty()) return false;
+bool SymbolTable::set_super(SymbolId super_name) {
+    if (current_class_ == NO_SYMBOL) return false;
     auto it = classes_.find(current_class_);
     if (it == classes_.end()) return false;
     it->second.super_name = super_name;
     return true;
 }
 
-bool SymbolTable::add_field(const std::string& owner_class,
-                            const std::string& field_name,
-                            const std::string& descriptor,
+bool SymbolTable::add_field(SymbolId owner_class,
+                            SymbolId field_name,
+                            SymbolId descriptor,
                             uint32_t pool_index) {
-    auto cit = classes_.find(owner_class);
-    if (cit == classes_.end()) {
-        ClassInfo ci;
-        ci.name = owner_class;
-        ci.super_name = "";
-        ci.pool_index = std::numeric_limits<uint32_t>::max();
-        classes_[owner_class] = ci;
-        cit = classes_.find(owner_class);
-    }
+    ClassInfo& ci = class_entry(owner_class);
 
-    std::string key = make_field_key(owner_class, field_name);
+    SymbolId key = make_field_key(owner_class, field_name);
     if (fields_.find(key) != fields_.end()) {
         return false;
     }
@@ -102,17 +141,17 @@ bool SymbolTable::add_field(const std::string& owner_class,
     fi.descriptor = descriptor;
     fi.pool_index = pool_index;
     fields_[key] = fi;
-    cit->second.fields.push_back(fi);
+    ci.fields.push_back(fi);
     return true;
 }
 
 bool SymbolTable::end_class() {
-    if (current_class_.empty()) return false;
-    current_class_.clear();
+    if (current_class_ == NO_SYMBOL) return false;
+    current_class_ = NO_SYMBOL;
     return true;
 }
 
-std::pair<bool, ClassInfo> SymbolTable::get_class(const std::string& class_name) const {
+std::pair<bool, ClassInfo> SymbolTable::get_class(SymbolId class_name) const {
     auto it = classes_.find(class_name);
     if (it == classes_.end()) return {false, ClassInfo{}};
     return {true, it->second};
@@ -120,24 +159,25 @@ std::pair<bool, ClassInfo> SymbolTable::get_class(const std::string& class_name)
 
 // ----- Methods (.method / .limit / .entry / .end) -----
 
-bool SymbolTable::begin_method(const std::string& method_name,
+bool SymbolTable::begin_method(SymbolId method_name,
                                const std::string& signature) {
-    std::string key = make_method_key(current_class_, method_name, signature);
+    SymbolId key = make_method_key(current_class_, method_name, signature);
 
-    std::cout << "KEY " << key << std::endl;
+    LOG_DEBUG("method key " << names_->name(key));
     if (methods_.find(key) != methods_.end()) {
         return false;
     }
     MethodInfo mi;
     mi.name = method_name;
     mi.signature = signature;
-    mi.address = lc_bytes_;          // mark start address at current LC
+    mi.address = base_address_ + lc_bytes_;   // mark start address at current LC
+    mi.first_instr = instr_count_;
     mi.size = 0;                     // <-- NEW: will be filled at end_method
     mi.stack_limit = 0;
     mi.locals_limit = 0;
     methods_[key] = mi;
 
-    if (!current_class_.empty()) {
+    if (current_class_ != NO_SYMBOL) {
         auto cit = classes_.find(current_class_);
         if (cit != classes_.end()) {
             cit->second.methods.push_back(key);
@@ -149,66 +189,83 @@ bool SymbolTable::begin_method(const std::string& method_name,
 }
 
 bool SymbolTable::set_method_stack_limit(uint32_t limit) {
-    if (current_method_key_.empty()) return false;
+    if (current_method_key_ == NO_SYMBOL) return false;
     auto it = methods_.find(current_method_key_);
     if (it == methods_.end()) return false;
     it->second.stack_limit = limit;
+    it->second.has_stack_limit = true;
     return true;
 }
 
-bool SymbolTable::define_data_symbol(const std::string& name, const std::vector<int32_t>& values) {
-    if (data_symbols_.find(name) != data_symbols_.end()) return false;
-    data_symbols_[name] = values;
+bool SymbolTable::set_stack_limit(SymbolId method_key, uint32_t limit) {
+    auto it = methods_.find(method_key);
+    if (it == methods_.end()) return false;
+    it->second.stack_limit = limit;
     return true;
 }
 
-std::pair<bool, std::vector<int32_t>> SymbolTable::get_data_symbol(const std::string& name) const {
+bool SymbolTable::define_data_symbol(SymbolId name, const std::vector<int32_t>& values) {
+    return data_symbols_.emplace(name, values).second;
+}
+
+std::pair<bool, std::vector<int32_t>> SymbolTable::get_data_symbol(SymbolId name) const {
     auto it = data_symbols_.find(name);
     if (it == data_symbols_.end()) return {false, {}};
     return {true, it->second};
 }
 
 bool SymbolTable::set_method_locals_limit(uint32_t limit) {
-    if (current_method_key_.empty()) return false;
+    if (current_method_key_ == NO_SYMBOL) return false;
     auto it = methods_.find(current_method_key_);
     if (it == methods_.end()) return false;
     it->second.locals_limit = limit;
+    it->second.has_locals_limit = true;
+    return true;
+}
+
+bool SymbolTable::set_locals_limit(SymbolId method_key, uint32_t limit) {
+    auto it = methods_.find(method_key);
+    if (it == methods_.end()) return false;
+    it->second.locals_limit = limit;
     return true;
 }
 
 bool SymbolTable::set_method_address(uint32_t address) {
-    if (current_method_key_.empty()) return false;
+    if (current_method_key_ == NO_SYMBOL) return false;
     auto it = methods_.find(current_method_key_);
     if (it == methods_.end()) return false;
     it->second.address = address;
+    it->second.first_instr = NO_INDEX;
     return true;
 }
 
 bool SymbolTable::end_method() {
-    if (current_method_key_.empty()) return false;
+    if (current_method_key_ == NO_SYMBOL) return false;
     auto it = methods_.find(current_method_key_);
     if (it == methods_.end()) return false;
 
     // <-- NEW: compute size based on LC
-    uint32_t current_end = lc_bytes_;
+    uint32_t current_end = base_address_ + lc_bytes_;
     if (current_end >= it->second.address) {
         it->second.size = current_end - it->second.address;
     } else {
         it->second.size = 0; // should not happen
     }
 
-    current_method_key_.clear();
+    it->second.end_instr = instr_count_;
+
+    current_method_key_ = NO_SYMBOL;
     return true;
 }
 
-bool SymbolTable::define_method(const std::string& class_name,
-                                const std::string& method_name,
+bool SymbolTable::define_method(SymbolId class_name,
+                                SymbolId method_name,
                                 const std::string& signature,
                                 uint32_t address,
                                 uint32_t stack_limit,
                                 uint32_t locals_limit
                                 ) {
-    std::string key = make_method_key(class_name, method_name, signature);
+    SymbolId key = make_method_key(class_name, method_name, signature);
     if (methods_.find(key) != methods_.end()) return false;
 
     MethodInfo mi;
@@ -217,33 +274,26 @@ bool SymbolTable::define_method(const std::string& class_name,
     mi.address = address;
     mi.size = 0; // will be fixed later if needed
     mi.stack_limit = stack_limit;
+    mi.has_stack_limit = true;
+    mi.has_locals_limit = true;
     mi.locals_limit = locals_limit;
 
     methods_[key] = mi;
 
-    if (!class_name.empty()) {
-        auto cit = classes_.find(class_name);
-        if (cit == classes_.end()) {
-            ClassInfo ci;
-            ci.name = class_name;
-            ci.super_name = "";
-            ci.pool_index = std::numeric_limits<uint32_t>::max();
-            classes_[class_name] = ci;
-            cit = classes_.find(class_name);
-        }
-        cit->second.methods.push_back(key);
+    if (class_name != NO_SYMBOL) {
+        class_entry(class_name).methods.push_back(key);
     }
 
     return true;
 }
 
-std::pair<bool, MethodInfo> SymbolTable::get_method(const std::string& method_key) const {
+std::pair<bool, MethodInfo> SymbolTable::get_method(SymbolId method_key) const {
     auto it = methods_.find(method_key);
     if (it == methods_.end()) return {false, MethodInfo{}};
     return {true, it->second};
 }
 
-std::pair<bool, FieldInfo> SymbolTable::get_field(const std::string& field_key) const {
+std::pair<bool, FieldInfo> SymbolTable::get_field(SymbolId field_key) const {
     auto it = fields_.find(field_key);
     if (it == fields_.end()) return {false, FieldInfo{}};
     return {true, it->second};
@@ -251,14 +301,20 @@ std::pair<bool, FieldInfo> SymbolTable::get_field(const std::string& field_key)
 
 // ----- Key builders -----
 
-std::string SymbolTable::make_field_key(const std::string& owner,
-                                        const std::string& name) {
-    return owner + "." + name;
+SymbolId SymbolTable::qualified(SymbolId owner, SymbolId name) {
+    std::string key(names_->name(owner));
+    key += '.';
+    key += names_->name(name);
+    return names_->intern(key);
+}
+
+SymbolId SymbolTable::make_field_key(SymbolId owner, SymbolId name) {
+    return qualified(owner, name);
 }
 
-std::string SymbolTable::make_method_key(const std::string& owner,
-                                         const std::string& name,
-                                         const std::string& sig) {
-    if (owner.empty()) return name;
-    return owner + "." + name;
+SymbolId SymbolTable::make_method_key(SymbolId owner, SymbolId name,
+                                      const std::string& sig) {
+    (void)sig;
+    if (owner == NO_SYMBOL) return name;
+    return qualified(owner, name);
 }
@@ -2,122 +2,252 @@
 // Developed By: Sahiti Vempalli
 // ============================================================================
 #include "assembler/Tokenizer.hpp"
-#include "assembler/Utils.hpp"
+#include "assembler/Scan.hpp"
+#include <algorithm>
 #include <cctype>
-#include <unordered_set>
+#include <thread>
 
-Tokenizer::Tokenizer(const std::string &src)
-    : src(src), pos(0), line(1), col(1) {}
+Tokenizer::Tokenizer(std::string_view src, assembler::Interner* names)
+    : src(src), in(nullptr), names(names), base(0), pos(0), tok_start(0),
+      line(1), line_start(0) {}
 
-bool Tokenizer::eof() const { return pos >= src.size(); }
-char Tokenizer::peek() const { return eof() ? '\0' : src[pos]; }
+Tokenizer::Tokenizer(assembler::StreamBuffer& in, assembler::Interner* names)
+    : src(in.window()), in(&in), names(names), base(0), pos(0), tok_start(0),
+      line(1), line_start(0) {}
+
+Token VectorTokenSource::next() {
+    if (idx < toks.size()) return toks[idx++];
+    return toks.empty() ? Token{TokenType::END_OF_FILE, "", 1, 1} : toks.back();
+}
+
+// Pulls more input into the window, keeping the token being scanned.
+bool Tokenizer::fill() {
+    if (!in) return false;
+    size_t keep = tok_start;
+    bool more = in->refill(keep);
+    base += keep;
+    pos -= keep;
+    tok_start = 0;
+    src = in->window();
+    return more;
+}
+
+bool Tokenizer::eof() { return pos >= src.size() && !fill(); }
+char Tokenizer::peek() { return eof() ? '\0' : src[pos]; }
+
+char Tokenizer::peek_at(size_t k) {
+    while (pos + k >= src.size())
+        if (!fill()) return '\0';
+    return src[pos + k];
+}
 
 char Tokenizer::get() {
     if (eof()) return '\0';
     char c = src[pos++];
     if (c == '\n') {
         ++line;
-        col = 1;
-    } else {
-        ++col;
+        line_start = base + pos;
     }
     return c;
 }
 
+// Whitespace runs (indentation, blank lines) are skipped a vector at a time;
+// line/col are recovered from the newline count and the last newline seen.
 void Tokenizer::skip_space() {
-    while (!eof() && std::isspace((unsigned char)peek())) get();
+    do {
+        auto run = assembler::scan::skip_space(src.data(), pos, src.size());
+        if (run.newlines) {
+            line += (int)run.newlines;
+            line_start = base + run.last_newline + 1;
+        }
+        pos = run.end;
+    } while (pos == src.size() && fill());
 }
 
-Token Tokenizer::make(TokenType t, const std::string &v, int l, int c) const {
-    return Token{t, v, l, c};
+// Comment bodies never contain a newline, so the column bookkeeping is
+// implicit in `pos`.
+void Tokenizer::skip_to_newline() {
+    do {
+        pos = assembler::scan::find_newline(src.data(), pos, src.size());
+    } while (pos == src.size() && fill());
 }
 
-std::vector<Token> Tokenizer::tokenize() {
-    std::vector<Token> toks;
+Token Tokenizer::make(TokenType t, std::string_view v, int l, int c) {
+    if (t != TokenType::END_OF_FILE) ++made;
+    return Token{t, v, l, c};
+}
 
-    static const std::unordered_set<std::string> MNEMONICS = {
-    "PUSH","POP","DUP","FPUSH","FPOP",
-    "IADD","ISUB","IMUL","IDIV","INEG",
-    "FADD","FSUB","FMUL","FDIV","FNEG",
-    "LOAD","STORE","LOAD_ARG",
-    "JMP","JZ","JNZ","CALL","RET",
-    "ICMP_EQ","ICMP_LT","ICMP_GT",
-    "ICMP_GEQ","ICMP_NEQ","ICMP_LEQ",
-    "FCMP_EQ","FCMP_LT","FCMP_GT",
-    "FCMP_GEQ","FCMP_NEQ","FCMP_LEQ",
-    "NEW","GETFIELD","PUTFIELD",
-    "INVOKEVIRTUAL","INVOKESPECIAL"
-};
-
-    while (!eof()) {
+Token Tokenizer::next() {
+    while (true) {
+        tok_start = pos;          // nothing before here needs to survive
         skip_space();
+        tok_start = pos;
         if (eof()) break;
 
-        int start_line = line, start_col = col;
+        int start_line = line, start_col = col();
         char c = peek();
 
         // Comment: ';' or '//'
         if (c == ';') {
-            std::string val;
-            while (!eof() && get() != '\n')
-                val.push_back(src[pos - 1]);
-            toks.push_back(make(TokenType::COMMENT, val, start_line, start_col));
-            continue;
+            skip_to_newline();
+            Token t = make(TokenType::COMMENT, src.substr(tok_start, pos - tok_start),
+                           start_line, start_col);
+            // ';' comments swallow their newline. It is already in the
+            // window (else this is EOF), so get() cannot move `t`'s bytes.
+            if (pos < src.size()) get();
+            return t;
         }
-        if (c == '/' && pos + 1 < src.size() && src[pos + 1] == '/') {
+        if (c == '/' && peek_at(1) == '/') {
             get(); get(); // consume both slashes
-            std::string val;
-            while (!eof() && peek() != '\n') val.push_back(get());
-            toks.push_back(make(TokenType::COMMENT, val, start_line, start_col));
-            continue;
+            tok_start = pos;
+            skip_to_newline();
+            return make(TokenType::COMMENT, src.substr(tok_start, pos - tok_start),
+                        start_line, start_col);
         }
 
         // Identifiers, mnemonics, labels
         if (std::isalpha((unsigned char)c) || c == '_' || c == '.') {
-            std::string ident;
             while (!eof() && (std::isalnum((unsigned char)peek()) || peek() == '_' || peek() == '.'))
-                ident.push_back(get());
+                get();
+            size_t len = pos - tok_start;
+            std::string_view ident = src.substr(tok_start, len);
               // Directives start with '.'
-            if (!ident.empty() && ident[0] == '.') {
-                toks.push_back(make(TokenType::DIRECTIVE, ident, start_line, start_col));
-                continue;
+            if (ident[0] == '.') {
+                Token t = make(TokenType::DIRECTIVE, ident, start_line, start_col);
+                if (const Keyword* kw = find_keyword(ident)) t.dir = kw->dir;
+                return t;
             }
             skip_space();
+            ident = src.substr(tok_start, len);   // the window may have moved
             if (!eof() && peek() == ':') {
                 get(); // consume ':'
-                toks.push_back(make(TokenType::LABEL_DEF, ident, start_line, start_col));
-                continue;
+                Token t = make(TokenType::LABEL_DEF, ident, start_line, start_col);
+                if (names) t.sym = names->intern(ident);
+                return t;
             }
 
-            std::string up = to_uppercopy(ident);
-            if (MNEMONICS.count(up)) {
-                toks.push_back(make(TokenType::MNEMONIC, up, start_line, start_col));
-            } else {
-                toks.push_back(make(TokenType::IDENT, ident, start_line, start_col));
+            // Mnemonic tokens carry the canonical upper-case spelling and
+            // the resolved opcode, so the parser never looks them up again.
+            const Keyword* kw = find_keyword(ident);
+            if (kw && kw->op != OpCode::INVALID) {
+                Token t = make(TokenType::MNEMONIC, kw->name, start_line, start_col);
+                t.op = kw->op;
+                return t;
             }
-            continue;
+            Token t = make(TokenType::IDENT, ident, start_line, start_col);
+            if (names) t.sym = names->intern(ident);
+            return t;
         }
 
         // Numbers (support negative)
-        if (std::isdigit((unsigned char)c) || (c == '-' && pos + 1 < src.size() && std::isdigit((unsigned char)src[pos + 1]))) {
-            std::string num;
-            if (peek() == '-') num.push_back(get());
-            while (!eof() && std::isdigit((unsigned char)peek())) num.push_back(get());
-            toks.push_back(make(TokenType::NUMBER, num, start_line, start_col));
-            continue;
+        if (std::isdigit((unsigned char)c) || (c == '-' && std::isdigit((unsigned char)peek_at(1)))) {
+            if (peek() == '-') get();
+            while (!eof() && std::isdigit((unsigned char)peek())) get();
+            return make(TokenType::NUMBER, src.substr(tok_start, pos - tok_start),
+                        start_line, start_col);
         }
 
         // Comma
         if (c == ',') {
             get();
-            toks.push_back(make(TokenType::COMMA, ",", start_line, start_col));
-            continue;
+            return make(TokenType::COMMA, ",", start_line, start_col);
         }
 
         // Unknown: skip but consume
         get();
     }
 
-    toks.push_back(make(TokenType::END_OF_FILE, "", line, col));
+    return make(TokenType::END_OF_FILE, "", line, col());
+}
+
+std::vector<Token> Tokenizer::tokenize() {
+    std::vector<Token> toks;
+    do {
+        toks.push_back(next());
+    } while (toks.back().type != TokenType::END_OF_FILE);
+    return toks;
+}
+
+// Start of the line after `from`, moved further while the next line would
+// begin (after blanks) with ':' - a label definition may put whitespace,
+// including newlines, between the name and its colon, and that token must
+// not be cut in two.
+static size_t chunk_boundary(std::string_view src, size_t from) {
+    size_t b = from;
+    while (true) {
+        b = assembler::scan::find_newline(src.data(), b, src.size());
+        if (b >= src.size()) return src.size();
+        ++b;
+        size_t next = assembler::scan::skip_space(src.data(), b, src.size()).end;
+        if (next >= src.size()) return src.size();
+        if (src[next] != ':') return b;
+    }
+}
+
+std::vector<Token> Tokenizer::tokenize_parallel(std::string_view src, unsigned jobs,
+                                                assembler::Interner* names,
+                                                size_t min_chunk) {
+    if (min_chunk == 0) min_chunk = 1;
+    size_t max_jobs = src.size() / min_chunk;
+    if (jobs > max_jobs) jobs = (unsigned)max_jobs;
+    if (jobs <= 1) return Tokenizer(src, names).tokenize();
+
+    // Chunk i covers [starts[i], starts[i + 1]); every chunk but the first
+    // begins at the start of a line.
+    std::vector<size_t> starts{0};
+    for (unsigned i = 1; i < jobs; ++i) {
+        size_t b = chunk_boundary(src, std::max(starts.back(), src.size() / jobs * i));
+        if (b >= src.size()) break;
+        if (b > starts.back()) starts.push_back(b);
+    }
+    starts.push_back(src.size());
+    size_t nchunks = starts.size() - 1;
+
+    std::vector<std::vector<Token>> parts(nchunks);
+    {
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < nchunks; ++i) {
+            workers.emplace_back([&, i] {
+                parts[i] = Tokenizer(src.substr(starts[i], starts[i + 1] - starts[i])).tokenize();
+            });
+        }
+        for (auto& w : workers) w.join();
+    }
+
+    // Each chunk ends right after a newline, so its END_OF_FILE sits on
+    // the first line of the next chunk: that gives the line offsets. All
+    // EOF tokens but the last are dropped.
+    std::vector<size_t> out_pos(nchunks + 1, 0);
+    std::vector<int> line_off(nchunks, 0);
+    for (size_t i = 0; i < nchunks; ++i) {
+        bool last = i + 1 == nchunks;
+        out_pos[i + 1] = out_pos[i] + parts[i].size() - (last ? 0 : 1);
+        if (!last) line_off[i + 1] = line_off[i] + parts[i].back().line - 1;
+    }
+
+    std::vector<Token> toks(out_pos[nchunks]);
+    {
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < nchunks; ++i) {
+            workers.emplace_back([&, i] {
+                size_t n = out_pos[i + 1] - out_pos[i];
+                for (size_t k = 0; k < n; ++k) {
+                    Token t = parts[i][k];
+                    t.line += line_off[i];
+                    toks[out_pos[i] + k] = t;
+                }
+                std::vector<Token>().swap(parts[i]);
+            });
+        }
+        for (auto& w : workers) w.join();
+    }
+
+    // The interner is not thread-safe; ids are assigned here, in source
+    // order, so they match a serial run.
+    if (names) {
+        for (Token& t : toks)
+            if (t.type == TokenType::IDENT || t.type == TokenType::LABEL_DEF)
+                t.sym = names->intern(t.value);
+    }
     return toks;
 }
@@ -4,19 +4,9 @@
 #include "assembler/Utils.hpp"
 #include "assembler/Token.hpp"
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <algorithm>
 
 
-std::string read_file(const std::string &path) {
-    std::ifstream in(path);
-    if (!in) return "";
-    std::ostringstream ss;
-    ss << in.rdbuf();
-    return ss.str();
-}
-
 // NEW: implement to_uppercopy here
 std::string to_uppercopy(const std::string &s) {
     std::string out = s;
@@ -24,20 +14,24 @@ std::string to_uppercopy(const std::string &s) {
     return out;
 }
 
-void print_tokens(const std::vector<Token> &toks) {
-    for (auto &t : toks) {
-        std::cout << "Token(";
+void print_tokens(const std::vector<Token> &toks, std::ostream &out) {
+    for (auto &t : toks) print_token(t, out);
+}
+
+void print_token(const Token &t, std::ostream &out) {
+    {
+        out << "Token(";
         switch (t.type) {
-            case TokenType::MNEMONIC:    std::cout << "MNEMONIC"; break;
-            case TokenType::DIRECTIVE:   std::cout << "DIRECTIVE"; break;
-            case TokenType::NUMBER:      std::cout << "NUMBER"; break;
-            case TokenType::IDENT:       std::cout << "IDENT"; break;
-            case TokenType::LABEL_DEF:   std::cout << "LABEL_DEF"; break;
-            case TokenType::COMMENT:     std::cout << "COMMENT"; break;
-            case TokenType::COMMA:       std::cout << "COMMA"; break;
-            case TokenType::END_OF_FILE: std::cout << "EOF"; break;
+            case TokenType::MNEMONIC:    out << "MNEMONIC"; break;
+            case TokenType::DIRECTIVE:   out << "DIRECTIVE"; break;
+            case TokenType::NUMBER:      out << "NUMBER"; break;
+            case TokenType::IDENT:       out << "IDENT"; break;
+            case TokenType::LABEL_DEF:   out << "LABEL_DEF"; break;
+            case TokenType::COMMENT:     out << "COMMENT"; break;
+            case TokenType::COMMA:       out << "COMMA"; break;
+            case TokenType::END_OF_FILE: out << "EOF"; break;
         }
-        std::cout << ", \"" << t.value << "\" @"
+        out << ", \"" << t.value << "\" @"
                   << t.line << ":" << t.col << ")\n";
     }
 }
@@ -51,100 +45,104 @@ void print_tokens(const std::vector<Token> &toks) {
 //         std::cout << "   (src line " << ins.src_line << ")\n";
 //     }
 // }
-void print_instructions(const std::vector<Instruction> &instrs) {
+void print_instructions(const std::vector<Instruction> &instrs,
+                        const assembler::Interner &names, std::ostream &out) {
     for (size_t i = 0; i < instrs.size(); i++) {
         const auto &ins = instrs[i];
-        std::cout << i << ": " << opcode_to_string(ins.op);
+        out << i << ": " << opcode_to_string(ins.op);
        for (auto &op : ins.operands) {
     switch (op.kind) {
         case Operand::Kind::Register:
-            std::cout << " R" << op.reg;
+            out << " R" << op.reg;
             break;
 
         case Operand::Kind::Immediate:
-            std::cout << " #" << op.imm;
+            out << " #" << op.imm;
             break;
 
         case Operand::Kind::Label:
-            std::cout << " " << op.label;
+            out << " " << names.name(op.sym);
             break;
 
         case Operand::Kind::FieldRef:
-            std::cout << " " << op.fieldref.clazz 
-                      << "/" << op.fieldref.name 
-                      << " : " << op.fieldref.desc;
+            out << " " << names.name(op.fieldref.clazz)
+                      << "/" << names.name(op.fieldref.name)
+                      << " : " << names.name(op.fieldref.desc);
             break;
 
         case Operand::Kind::MethodRef:
-            std::cout << " (methodref TODO)";
+            out << " (methodref TODO)";
             break;
 
         case Operand::Kind::ConstPoolIndex:
-            std::cout << " (cp#" << op.pool_index << ")";
+            out << " (cp#" << op.pool_index << ")";
             break;
         
     }
 }
-std::cout << "   (src line " << ins.src_line << ")\n";
+out << "   (src line " << ins.src_line << ")\n";
 
     }
 }
 
 //Function to print symbol table contents,added by Sahiti
-void print_symbol_table(const SymbolTable& symtab) {
-    std::cout << "== Symbol Table ==\n";
-    std::cout << "base: " << symtab.base() << ", code LC (bytes): " << symtab.lc() << "\n\n";
-
-    std::cout << "[labels]\n";
-    for (const auto& kv : symtab.labels()) {
-        std::cout << "  " << kv.first << " => " << kv.second.address
-                  << "  (src " << kv.second.line << ":" << kv.second.col << ")\n";
+void print_symbol_table(const SymbolTable& symtab, std::ostream& out) {
+    const assembler::Interner& names = symtab.names();
+    out << "== Symbol Table ==\n";
+    out << "base: " << symtab.base() << ", code LC (bytes): " << symtab.lc() << "\n\n";
+
+    out << "[labels]\n";
+    const auto& labels = symtab.labels();
+    for (SymbolId id = 0; id < labels.size(); ++id) {
+        if (!labels[id].defined) continue;
+        out << "  " << names.name(id) << " => " << labels[id].address
+                  << "  (src " << labels[id].line << ":" << labels[id].col << ")\n";
     }
 
-    std::cout << "\n[constants]\n";
+    out << "\n[constants]\n";
     for (const auto& kv : symtab.constants()) {
-        std::cout << "  " << kv.first << " = " << kv.second.value << "\n";
+        out << "  " << names.name(kv.first) << " = " << kv.second.value << "\n";
     }
 
-    std::cout << "\n[fields]\n";
+    out << "\n[fields]\n";
     for (const auto& kv : symtab.fields()) {
         const auto& f = kv.second;
-        std::cout << "  " << f.owner_class << "." << f.name
-                  << " : " << f.descriptor
+        out << "  " << names.name(f.owner_class) << "." << names.name(f.name)
+                  << " : " << names.name(f.descriptor)
                   << "  pool=" << (f.pool_index == UINT32_MAX ? -1 : (int)f.pool_index)
                   << "\n";
     }
 
-    std::cout << "\n[methods]\n";
+    out << "\n[methods]\n";
     for (const auto& kv : symtab.methods()) {
         const auto& m = kv.second;
-        std::cout << "  " << kv.first
+        out << "  " << names.name(kv.first)
                   << " @ " << m.address
                   << "  .limit stack " << m.stack_limit
                   << "  .limit locals " << m.locals_limit
                   << "\n";
     }
 
-    std::cout << "\n[classes]\n";
+    out << "\n[classes]\n";
     for (const auto& kv : symtab.classes()) {
         const auto& c = kv.second;
-        std::cout << "  .class " << c.name
-                  << "  .super " << c.super_name
+        out << "  .class " << names.name(c.name)
+                  << "  .super " << names.name(c.super_name)
                   << "  pool=" << (c.pool_index == UINT32_MAX ? -1 : (int)c.pool_index)
                   << "\n";
         if (!c.fields.empty()) {
-            std::cout << "    fields:";
+            out << "    fields:";
             for (const auto& f : c.fields) {
-                std::cout << " " << f.name;
+                out << " " << names.name(f.name);
             }
-            std::cout << "\n";
+            out << "\n";
         }
         if (!c.methods.empty()) {
-            std::cout << "    methods:";
+            out << "    methods:";
             for (const auto& mk : c.methods) {
-                std::cout << " " << mk;
+                out << " " << names.name(mk);
             }
-            std::cout << "\n";
+            out << "\n";
         }
     }
 }
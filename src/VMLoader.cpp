@@ -0,0 +1,282 @@
+// ============================================================================
+// VMLoader.cpp - reference loader for the .vm container
+// ============================================================================
+#include "assembler/VMLoader.hpp"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace assembler;
+using vm::get_u32;
+
+VMImage::~VMImage() { release(); }
+
+VMImage::VMImage(VMImage&& o) noexcept { *this = std::move(o); }
+
+VMImage& VMImage::operator=(VMImage&& o) noexcept {
+    if (this != &o) {
+        release();
+        bool own_copy = !o.mapped_ && o.data_;
+        copy_ = std::move(o.copy_);
+        data_ = own_copy ? copy_.data() : o.data_;
+        size_ = o.size_;
+        mapped_ = o.mapped_;
+        entry_ = o.entry_;
+        // Spans point into the data, which a moved vector keeps in place.
+        std::memcpy(sections_, o.sections_, sizeof(sections_));
+        o.data_ = nullptr; o.size_ = 0; o.mapped_ = false;
+        o.release();
+    }
+    return *this;
+}
+
+void VMImage::release() {
+#ifndef _WIN32
+    if (mapped_ && data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    copy_.clear();
+    data_ = nullptr; size_ = 0; mapped_ = false; entry_ = 0;
+    for (Span& s : sections_) s = Span();
+}
+
+bool VMImage::open(const std::string& path, std::string& error) {
+    release();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = ::mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data_ = static_cast<const uint8_t*>(p);
+            size_ = (std::size_t)st.st_size;
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+#endif
+    if (!data_) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+        copy_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = copy_.data();
+        size_ = copy_.size();
+    }
+    if (check(error)) return true;
+    release();
+    return false;
+}
+
+// Header, directory and section bounds: constant work per section.
+bool VMImage::check(std::string& error) {
+    if (size_ < vm::HEADER_SIZE || get_u32(data_) != vm::MAGIC) {
+        error = "not a VM file";
+        return false;
+    }
+    uint32_t version = get_u32(data_ + 4), header_size = get_u32(data_ + 8),
+             align = get_u32(data_ + 12), count = get_u32(data_ + 20),
+             dir = get_u32(data_ + 24), file_size = get_u32(data_ + 28);
+    if (version != vm::VERSION) {
+        error = "unsupported VM file version " + std::to_string(version);
+        return false;
+    }
+    if (header_size < vm::HEADER_SIZE || align < 4 || (align & (align - 1))) {
+        error = "bad header";
+        return false;
+    }
+    if (file_size != size_) {
+        error = "file is " + std::to_string(size_) + " bytes, header says " +
+                std::to_string(file_size);
+        return false;
+    }
+    if (dir < header_size || dir > size_ || count > (size_ - dir) / vm::DIR_ENTRY_SIZE) {
+        error = "section directory outside the file";
+        return false;
+    }
+    entry_ = get_u32(data_ + 16);
+
+    uint64_t dir_end = dir + uint64_t(count) * vm::DIR_ENTRY_SIZE;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* e = data_ + dir + i * vm::DIR_ENTRY_SIZE;
+        uint32_t kind = get_u32(e), off = get_u32(e + 4), size = get_u32(e + 8);
+        if (kind == 0 || kind > vm::SECTION_KINDS) continue;   // from a newer writer
+        if (sections_[kind].data) {
+            error = "section " + std::to_string(kind) + " appears twice";
+            return false;
+        }
+        if (off % align || off < dir_end || off > size_ || size > size_ - off) {
+            error = "section " + std::to_string(kind) + " is misaligned or outside the file";
+            return false;
+        }
+        sections_[kind] = Span{data_ + off, size, get_u32(e + 12)};
+    }
+
+    auto records = [&](vm::Section kind, uint32_t record, const char* what) {
+        const Span& s = section(kind);
+        if (uint64_t(s.count) * record == s.size) return true;
+        error = std::string(what) + " section size does not match its count";
+        return false;
+    };
+    if (!records(vm::Section::CLASSES, vm::CLASS_RECORD_SIZE, "class") ||
+        !records(vm::Section::FIELDS, vm::FIELD_RECORD_SIZE, "field") ||
+        !records(vm::Section::METHODS, vm::METHOD_RECORD_SIZE, "method") ||
+        !records(vm::Section::FUNCTIONS, vm::METHOD_RECORD_SIZE, "function"))
+        return false;
+
+    const Span& pool = section(vm::Section::POOL);
+    if (pool.size && (pool.size < 4 || get_u32(pool.data) != pool.count ||
+                      pool.count > (pool.size - 4) / 4)) {
+        error = "bad constant pool offset table";
+        return false;
+    }
+    if (!pool.size && pool.count) {
+        error = "empty constant pool with entries";
+        return false;
+    }
+    const Span& strings = section(vm::Section::STRINGS);
+    if (strings.size && strings.data[strings.size - 1] != 0) {
+        error = "string table is not NUL-terminated";
+        return false;
+    }
+    if (entry_ > code_size()) {
+        error = "entry point outside the code";
+        return false;
+    }
+    return true;
+}
+
+bool VMImage::constant(uint32_t index, PoolConstant& out) const {
+    const Span& pool = section(vm::Section::POOL);
+    if (index == 0 || index > pool.count) return false;
+    uint32_t off = get_u32(pool.data + 4 * index);
+    if (off > pool.size || pool.size - off < 9) return false;
+    const uint8_t* e = pool.data + off;
+    out.tag = static_cast<ConstTag>(e[0]);
+    out.bits = get_u32(e + 5);
+    out.str = {};
+    switch (out.tag) {
+        case ConstTag::INT:
+        case ConstTag::FLOAT:
+            return true;
+        case ConstTag::STRING: {
+            if (pool.size - off < 13) return false;
+            const Span& strings = section(vm::Section::STRINGS);
+            uint32_t at = get_u32(e + 9);
+            if (at > strings.size || out.bits > strings.size - at) return false;
+            out.str = std::string_view(reinterpret_cast<const char*>(strings.data) + at,
+                                       out.bits);
+            out.bits = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+ClassRecord VMImage::class_at(uint32_t i) const {
+    const uint8_t* r = section(vm::Section::CLASSES).data + i * vm::CLASS_RECORD_SIZE;
+    return {get_u32(r), get_u32(r + 4), get_u32(r + 8), get_u32(r + 12),
+            get_u32(r + 16), get_u32(r + 20)};
+}
+
+FieldRecord VMImage::field_at(uint32_t i) const {
+    const uint8_t* r = section(vm::Section::FIELDS).data + i * vm::FIELD_RECORD_SIZE;
+    return {get_u32(r), get_u32(r + 4)};
+}
+
+MethodRecord VMImage::method_record(const uint8_t* r) {
+    return {get_u32(r), get_u32(r + 4), get_u32(r + 8), get_u32(r + 12), get_u32(r + 16)};
+}
+
+MethodRecord VMImage::method_at(uint32_t i) const {
+    return method_record(section(vm::Section::METHODS).data + i * vm::METHOD_RECORD_SIZE);
+}
+
+MethodRecord VMImage::function_at(uint32_t i) const {
+    return method_record(section(vm::Section::FUNCTIONS).data + i * vm::METHOD_RECORD_SIZE);
+}
+
+bool VMImage::find_function(std::string_view name, MethodRecord& out) const {
+    uint32_t lo = 0, hi = function_count();
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (string_at(function_at(mid).name) < name) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == function_count()) return false;
+    out = function_at(lo);
+    return string_at(out.name) == name;
+}
+
+std::string_view VMImage::string_at(uint32_t offset) const {
+    const Span& strings = section(vm::Section::STRINGS);
+    if (offset >= strings.size) return {};
+    // check() made sure the table ends in a NUL
+    const char* s = reinterpret_cast<const char*>(strings.data) + offset;
+    return std::string_view(s, std::strlen(s));
+}
+
+bool VMImage::verify(std::string& error) const {
+    const Span& pool = section(vm::Section::POOL);
+    const Span& strings = section(vm::Section::STRINGS);
+    for (uint32_t n = 1; n <= pool.count; ++n) {
+        PoolConstant c;
+        uint32_t off = get_u32(pool.data + 4 * n);
+        if (!constant(n, c) || get_u32(pool.data + off + 1) != n) {
+            error = "bad constant pool entry #" + std::to_string(n);
+            return false;
+        }
+    }
+    auto name_ok = [&](uint32_t off) { return off < strings.size; };
+
+    for (uint32_t i = 0; i < class_count(); ++i) {
+        ClassRecord c = class_at(i);
+        bool ok = name_ok(c.name) &&
+                  // superclasses come first
+                  (c.super == vm::NO_CLASS || c.super < i) &&
+                  c.first_field <= field_count() &&
+                  c.field_count <= field_count() - c.first_field &&
+                  c.first_method <= method_count() &&
+                  c.method_count <= method_count() - c.first_method;
+        if (!ok) {
+            error = "bad class record " + std::to_string(i);
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < field_count(); ++i) {
+        if (!name_ok(field_at(i).name)) {
+            error = "bad field record " + std::to_string(i);
+            return false;
+        }
+    }
+    auto method_ok = [&](const MethodRecord& m) {
+        return name_ok(m.name) && m.address <= code_size() && m.size <= code_size() - m.address;
+    };
+    for (uint32_t i = 0; i < method_count(); ++i) {
+        if (!method_ok(method_at(i))) {
+            error = "bad method record " + std::to_string(i);
+            return false;
+        }
+    }
+    // Functions must also be in strict name order for find_function().
+    for (uint32_t i = 0; i < function_count(); ++i) {
+        MethodRecord f = function_at(i);
+        if (!method_ok(f) ||
+            (i && !(string_at(function_at(i - 1).name) < string_at(f.name)))) {
+            error = "bad function record " + std::to_string(i);
+            return false;
+        }
+    }
+    return true;
+}
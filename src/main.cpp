@@ -1,142 +1,441 @@
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <thread>
 #include "assembler/Tokenizer.hpp"
 #include "assembler/Parser.hpp"
 #include "assembler/Utils.hpp"
 #include "assembler/SymbolTable.hpp"
-#include "assembler/IR.hpp"
+#include "assembler/Encoder.hpp"
 #include "assembler/Emitter.hpp"
 #include "assembler/ConstantPool.hpp"
+#include "assembler/StringTable.hpp"
+#include "assembler/VMLoader.hpp"
+#include "assembler/Input.hpp"
+#include "assembler/Stats.hpp"
+#include "assembler/Log.hpp"
+#include "assembler/Opcodes.hpp"
 
 
+// Prints every token as the parser pulls it (used when the input is a
+// stream that cannot be read twice).
+class PrintingTokenSource : public TokenSource {
+public:
+    PrintingTokenSource(TokenSource& inner, std::ostream& out) : inner(inner), out(out) {}
+    Token next() override {
+        Token t = inner.next();
+        print_token(t, out);
+        return t;
+    }
+
+private:
+    TokenSource& inner;
+    std::ostream& out;
+};
+
+// Stage dumps selected with --dump=...
+enum Dump : unsigned {
+    DUMP_TOKENS = 1u << 0,
+    DUMP_INSTRS = 1u << 1,
+    DUMP_SYMTAB = 1u << 2,
+    DUMP_POOL   = 1u << 3,
+    DUMP_CODE   = 1u << 4,
+    DUMP_ALL    = DUMP_TOKENS | DUMP_INSTRS | DUMP_SYMTAB | DUMP_POOL | DUMP_CODE,
+};
+
+// Parses a comma-separated list such as "tokens,code"; returns false on an
+// unknown name.
+static bool parse_dumps(const std::string& list, unsigned& mask) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        std::string name = list.substr(start, end - start);
+        if (name == "tokens")      mask |= DUMP_TOKENS;
+        else if (name == "instrs") mask |= DUMP_INSTRS;
+        else if (name == "symtab") mask |= DUMP_SYMTAB;
+        else if (name == "pool")   mask |= DUMP_POOL;
+        else if (name == "code")   mask |= DUMP_CODE;
+        else if (name == "ir")     mask |= DUMP_CODE;   // old name
+        else if (name == "all")    mask |= DUMP_ALL;
+        else if (!name.empty())    return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+// Parses a comma-separated list of fusions such as "iinc,if_icmp".
+static bool parse_fusions(const std::string& list, assembler::OptOptions& opts) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        std::string name = list.substr(start, end - start);
+        if (!name.empty() && !assembler::enable_fusion(name, opts)) return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+// Parses the -j thread count: digits only, 0 meaning all cores.
+static bool parse_jobs(const char* text, unsigned& jobs) {
+    const char* end = text + std::strlen(text);
+    auto r = std::from_chars(text, end, jobs);
+    return r.ec == std::errc() && r.ptr == end && r.ptr != text;
+}
+
+static bool parse_log_level(const std::string& name, assembler::log::Level& lvl) {
+    using assembler::log::Level;
+    if (name == "error")      lvl = Level::Error;
+    else if (name == "warn")  lvl = Level::Warn;
+    else if (name == "info")  lvl = Level::Info;
+    else if (name == "debug") lvl = Level::Debug;
+    else if (name == "trace") lvl = Level::Trace;
+    else return false;
+    return true;
+}
+
+static const char* USAGE =
+    "Usage: assembler [options] <source.asm | ->\n"
+    "  -o FILE              output file (default: source with .vm)\n"
+    "  -j N                 tokenizer threads for mapped input (0 = all cores)\n"
+    "  --no-relax           keep every jump in its 16-bit form\n"
+    "  -O                   fold constants, thread jumps, drop dead code,\n"
+    "                       peephole-optimize, share local slots\n"
+    "  --fuse=LIST          superinstructions: iinc,if_icmp or all\n"
+    "  --fuse-profile FILE  fuse what makes up >= 1% of FILE's opcode pairs\n"
+    "  --dump=LIST          stage dumps: tokens,instrs,symtab,pool,code or all\n"
+    "  --dump-file FILE     write dumps to FILE instead of stdout\n"
+    "  --verify             load the written file back and check it\n"
+    "  -v, -vv              log info / debug messages to stderr\n"
+    "  --log-level=LEVEL    error, warn (default), info, debug or trace\n"
+    "  --stats              print a JSON timing report on stderr\n"
+    "  --stats-json FILE    write the JSON timing report to FILE\n";
+
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: assembler <source.asm>\n";
+    std::string inputFile, outFile;
+    std::string statsFile, dumpFile, profileFile;
+    bool stats = false;
+    bool relax = true;
+    bool verify = false;
+    assembler::OptOptions opts;
+    unsigned jobs = 1;
+    unsigned dumps = 0;
+    assembler::log::Level logLevel = assembler::log::Level::Warn;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool takes_value = arg == "-o" || arg == "-j" || arg == "--fuse-profile" ||
+                           arg == "--stats-json" || arg == "--dump-file";
+        if (takes_value && i + 1 == argc) {
+            std::cerr << "Error: " << arg << " needs a value\n" << USAGE;
+            return 1;
+        }
+        if (arg == "-o") outFile = argv[++i];
+        else if (arg == "-j") {
+            if (!parse_jobs(argv[++i], jobs)) {
+                std::cerr << "Error: -j wants a thread count, got '" << argv[i] << "'\n" << USAGE;
+                return 1;
+            }
+        }
+        else if (arg == "--no-relax") relax = false;
+        else if (arg == "--verify") verify = true;
+        else if (arg == "-O") opts.peephole = opts.fold = opts.cfg = opts.locals = true;
+        else if (arg == "--fuse-profile") profileFile = argv[++i];
+        else if (arg == "--stats") stats = true;
+        else if (arg == "--stats-json") { stats = true; statsFile = argv[++i]; }
+        else if (arg == "--dump-file") dumpFile = argv[++i];
+        else if (arg == "-v") logLevel = assembler::log::Level::Info;
+        else if (arg == "-vv") logLevel = assembler::log::Level::Debug;
+        else if (arg.rfind("--dump=", 0) == 0) {
+            if (!parse_dumps(arg.substr(7), dumps)) {
+                std::cerr << "Error: unknown dump in '" << arg << "'\n" << USAGE;
+                return 1;
+            }
+        } else if (arg.rfind("--fuse=", 0) == 0) {
+            if (!parse_fusions(arg.substr(7), opts)) {
+                std::cerr << "Error: unknown fusion in '" << arg << "'\n" << USAGE;
+                return 1;
+            }
+        } else if (arg.rfind("--log-level=", 0) == 0) {
+            if (!parse_log_level(arg.substr(12), logLevel)) {
+                std::cerr << "Error: unknown log level in '" << arg << "'\n" << USAGE;
+                return 1;
+            }
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            // "-" alone is stdin
+            std::cerr << "Error: unknown option '" << arg << "'\n" << USAGE;
+            return 1;
+        } else inputFile = arg;
+    }
+    if (inputFile.empty()) {
+        std::cerr << USAGE;
         return 1;
     }
+    if (stats) assembler::stats::enable();
+    assembler::log::set_level(logLevel);
 
-    // Read source file
-    std::string src = read_file(argv[1]);
-    if (src.empty()) {
-        std::cerr << "Error: could not read file '" << argv[1] << "'\n";
-        return 2;
+    // A profile turns on each fusion whose opcode pairs make up at least
+    // 1% of the pairs it counts.
+    if (!profileFile.empty()) {
+        std::ifstream pf(profileFile);
+        assembler::PairProfile profile;
+        std::string err;
+        if (!pf) {
+            std::cerr << "Error: could not open profile '" << profileFile << "'\n";
+            return 1;
+        }
+        if (!assembler::read_pair_profile(pf, profile, err)) {
+            std::cerr << "Error: " << profileFile << ": " << err << "\n";
+            return 1;
+        }
+        for (const std::string& f : assembler::select_fusions(profile, 0.01, opts))
+            LOG_INFO("profile enables fusion " << f);
+    }
+
+    // Dumps can run to hundreds of megabytes on large inputs: keep them off
+    // the synchronized stdio path and flush once at exit.
+    std::ios::sync_with_stdio(false);
+    std::ofstream dumpStream;
+    std::vector<char> dumpBuf;
+    if (!dumpFile.empty()) {
+        dumpBuf.resize(1 << 20);
+        dumpStream.rdbuf()->pubsetbuf(dumpBuf.data(), (std::streamsize)dumpBuf.size());
+        dumpStream.open(dumpFile);
+        if (!dumpStream) {
+            std::cerr << "Error: could not open dump file '" << dumpFile << "'\n";
+            return 1;
+        }
     }
+    std::ostream& out = dumpFile.empty() ? std::cout : dumpStream;
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
 
-    // Tokenize
-    Tokenizer tokenizer(src);
-    auto tokens = tokenizer.tokenize();
+    // Regular files are memory-mapped; pipes and stdin ("-") are streamed
+    // through a fixed-size buffer.
+    assembler::SourceFile source = assembler::SourceFile::open(inputFile);
+    assembler::StreamBuffer stream(source.fd());
+    auto read_failed = [&]() {
+        std::cerr << "Error: could not read file '" << inputFile << "'";
+        if (stream.error()) std::cerr << ": " << std::strerror(stream.error());
+        std::cerr << "\n";
+        return 2;
+    };
+    if (!source.ok() || (!source.mapped() && !stream.refill(0)))
+        return read_failed();
 
-    std::cout << "=== TOKENS ===\n";
-    print_tokens(tokens);
+    // With -j > 1 a mapped file is tokenized up front on worker threads;
+    // otherwise the parser pulls tokens straight from the mapping or the
+    // stream. --stats reports whichever path the run takes: when tokens are
+    // pulled, tokenizing is timed as part of the "parse" phase.
+    assembler::Interner names;   // every identifier, shared by all stages
+    std::vector<Token> tokens;
+    bool parallel = source.mapped() && jobs > 1;
+    if (parallel) {
+        assembler::stats::Phase phase("tokenize");
+        tokens = Tokenizer::tokenize_parallel(source.text(), jobs, &names);
+        assembler::stats::count("tokens", tokens.size() - 1);   // END_OF_FILE
+    }
+
+    // Tokenize (a separate pass over the mapping, only for the dump; a
+    // stream is dumped as the parser pulls from it)
+    if (dumps & DUMP_TOKENS) {
+        out << "=== TOKENS ===\n";
+        if (parallel) {
+            print_tokens(tokens, out);
+        } else if (source.mapped()) {
+            Tokenizer dump(source.text());
+            Token t;
+            do {
+                t = dump.next();
+                print_token(t, out);
+            } while (t.type != TokenType::END_OF_FILE);
+        }
+    }
 
     // Parse
-    Parser parser(tokens);
+    Tokenizer tokenizer = source.mapped() ? Tokenizer(source.text(), &names)
+                                          : Tokenizer(stream, &names);
+    VectorTokenSource replay(tokens);
+    PrintingTokenSource tee(tokenizer, out);
+    TokenSource& tsrc = parallel ? static_cast<TokenSource&>(replay)
+                      : source.mapped() ? static_cast<TokenSource&>(tokenizer)
+                      : (dumps & DUMP_TOKENS) ? static_cast<TokenSource&>(tee)
+                      : static_cast<TokenSource&>(tokenizer);
+    Parser parser(tsrc, names);
+    parser.set_relax(relax);
+    parser.set_optimize(opts);
     auto instructions = parser.parse();
+    // A failed read ends the stream like EOF; the parse saw only part of it.
+    if (stream.error()) return read_failed();
+    if (!parallel) assembler::stats::count("tokens", tokenizer.count());
+    if (opts.any()) {
+        const assembler::OptReport& rep = parser.opt_report();
+        LOG_INFO("optimizer: " << rep.instrs_before << " -> " << rep.instrs_after
+                 << " instructions");
+        for (const auto& r : rep.rules)
+            LOG_INFO("  " << r.name << ": " << r.hits);
+        assembler::stats::count("instructions_removed", rep.instrs_before - rep.instrs_after);
+    }
+    assembler::stats::count("instructions", instructions.size());
+    assembler::stats::count("labels", parser.symbols().label_count());
+    assembler::stats::count("symbols", names.size());
+    assembler::stats::count("fixups", parser.symbols().fixups().size());
+    assembler::stats::count("pool_entries", parser.get_constpool().entries().size());
 
-    std::cout << "\n=== INSTRUCTIONS ===\n";
-    print_instructions(instructions);
+    if (dumps & DUMP_INSTRS) {
+        out << "\n=== INSTRUCTIONS ===\n";
+        print_instructions(instructions, parser.names(), out);
+    }
 
     // Show symbol table contents
-    std::cout << "\n=== SYMBOL TABLE ===\n";
     const SymbolTable& symtab = parser.symbols();
-
-    for (auto &kv : symtab.labels()) {
-        std::cout << "Label " << kv.first
-                  << " -> addr=" << kv.second.address
-                  << " (defined at line " << kv.second.line
-                  << ", col " << kv.second.col << ")\n";
-    }
-    for (auto &kv : symtab.constants()) {
-        std::cout << "Const " << kv.first
-                  << " = " << kv.second.value << "\n";
+    if (dumps & DUMP_SYMTAB) {
+        out << "\n=== SYMBOL TABLE ===\n";
+        const auto& labels = symtab.labels();
+        for (SymbolId id = 0; id < labels.size(); ++id) {
+            if (!labels[id].defined) continue;
+            out << "Label " << names.name(id)
+                << " -> addr=" << labels[id].address
+                << " (defined at line " << labels[id].line
+                << ", col " << labels[id].col << ")\n";
+        }
+        for (auto &kv : symtab.constants()) {
+            out << "Const " << names.name(kv.first)
+                << " = " << kv.second.value << "\n";
+        }
+        for (auto &kv : symtab.methods()) {
+            out << "Method " << names.name(kv.first)
+                << " addr=" << kv.second.address
+                << " stack=" << kv.second.stack_limit
+                << " locals=" << kv.second.locals_limit
+                << "\n";
+        }
+        for (auto &kv : symtab.classes()) {
+            out << "Class " << names.name(kv.first)
+                << " super=" << names.name(kv.second.super_name) << "\n";
+        }
     }
-    for (auto &kv : symtab.methods()) {
-        std::cout << "Method " << kv.first
-                  << " addr=" << kv.second.address
-                  << " stack=" << kv.second.stack_limit
-                  << " locals=" << kv.second.locals_limit
-                  << "\n";
+
+    // Superclass cycles only show once every class is known
+    std::vector<std::string> errors = parser.errors();
+    assembler::metadataOrder(symtab, &errors);
+    if (!errors.empty()) {
+        out.flush();
+        std::cerr << "\n=== ERRORS ===\n";
+        for (auto &err : errors)
+            std::cerr << err << "\n";
+        return 3;
     }
-    for (auto &kv : symtab.classes()) {
-        std::cout << "Class " << kv.first
-                  << " super=" << kv.second.super_name << "\n";
+
+    // === Constant Pool Debug Print ===
+    if (dumps & DUMP_POOL) {
+        out << "\n=== CONSTANT POOL ===\n";
+        const assembler::ConstantPool& pool = parser.get_constpool();
+        for (auto &e : pool.entries()) {
+            out << "#" << e.index << " ";
+            switch (e.tag) {
+                case assembler::ConstTag::INT:      out << "INT "; break;
+                case assembler::ConstTag::FLOAT:    out << "FLOAT "; break;
+                case assembler::ConstTag::STRING:   out << "STRING "; break;
+            }
+            out << pool.text(e) << "\n";
+        }
     }
 
-    if (!parser.errors().empty()) {
+    // Encode straight into the code section, sized by the pass-1 LC
+    assembler::Encoder::Report enc;
+    {
+        assembler::stats::Phase phase("encode");
+        enc = assembler::Encoder::encode(instructions, parser.names(),
+                                         symtab.fixups(), symtab.lc());
+    }
+    if (!enc.errors.empty()) {
+        out.flush();
         std::cerr << "\n=== ERRORS ===\n";
-        for (auto &err : parser.errors())
+        for (auto &err : enc.errors)
             std::cerr << err << "\n";
         return 3;
     }
 
-    // === Constant Pool Debug Print ===
-    const auto &cp = parser.get_constpool().entries();
-    std::cout << "\n=== CONSTANT POOL ===\n";
-    for (auto &e : cp) {
-        std::cout << "#" << e.index << " ";
-        switch (e.tag) {
-            case assembler::ConstTag::INT:      std::cout << "INT "; break;
-            case assembler::ConstTag::FLOAT:    std::cout << "FLOAT "; break;
-            case assembler::ConstTag::STRING:   std::cout << "STRING "; break;
+    if (dumps & DUMP_CODE) {
+        out << "\n=== CODE ===\n";
+        for (size_t i = 0; i < enc.locs.size(); ++i) {
+            const auto &loc = enc.locs[i];
+            const uint8_t *p = enc.code.data() + loc.offset;
+            const assembler::OpcodeInfo &info = assembler::opcode_info(*p);
+            out << i << ": @" << loc.offset << " opcode=0x"
+                << std::hex << std::setw(2) << std::setfill('0')
+                << (int)*p << std::dec;
+            for (size_t k = 0; k < info.operand_count(); ++k)
+                out << " " << assembler::read_operand(p + info.operand_offset(k),
+                                                      info.operand_width(k),
+                                                      assembler::is_signed(info.operand_type(k)));
+            out << "   (src line " << loc.line << ")\n";
         }
-        std::cout << e.str << "\n";
-    }
-
-    // Build IR
-    auto irrep = assembler::IRBuilder::build(instructions);
-
-    std::cout << "\n=== IR WORDS ===\n";
-    for (size_t i = 0; i < irrep.words.size(); ++i) {
-        const auto &w = irrep.words[i];
-        std::cout << i << ": opcode=0x"
-                  << std::hex << std::setw(2) << std::setfill('0')
-                  << (int)w.opcode << std::dec;
-        for (auto v : w.imm) std::cout << " " << v;
-        std::cout << "   (src line " << w.src_line << ")\n";
-    }
-
-    // Convert IR → raw bytecode
-    std::vector<uint8_t> code;
-    for (auto &w : irrep.words) {
-        code.push_back(w.opcode);
-        for (size_t i = 0; i < w.imm.size(); ++i) {
-    int imm = w.imm[i];
-    if (w.opcode == static_cast<uint8_t>(OpCode::JMP)|| w.opcode == static_cast<uint8_t>(OpCode::JZ) || w.opcode == static_cast<uint8_t>(OpCode::JNZ)) {
-        // write 16-bit little-endian
-        code.push_back(imm & 0xFF);
-        code.push_back((imm >> 8) & 0xFF);
-    } else {
-        // write 32-bit little-endian
-        for (int b = 0; b < 4; ++b)
-            code.push_back((imm >> (8 * b)) & 0xFF);
     }
-}
 
+    // String table: string constants and the names class metadata uses
+    assembler::StringTable strings;
+    {
+        assembler::stats::Phase phase("strings");
+        parser.get_constpool().add_strings(strings);
+        assembler::addMetadataNames(symtab, strings);
+        strings.finish();
     }
-    
 
     // Emit constant pool bytes
     std::vector<uint8_t> pool_bytes;
-    parser.get_constpool().emit(pool_bytes);
-
-    // Final buffer = [constant pool][code]
-    std::vector<uint8_t> final_bytes;
-    final_bytes.insert(final_bytes.end(), pool_bytes.begin(), pool_bytes.end());
-    final_bytes.insert(final_bytes.end(), code.begin(), code.end());
+    {
+        assembler::stats::Phase phase("constpool");
+        parser.get_constpool().emit(pool_bytes, strings);
+    }
+    assembler::stats::count("code_bytes", enc.code.size());
+    assembler::stats::count("pool_bytes", pool_bytes.size());
+    assembler::stats::count("string_bytes", strings.size_bytes());
 
     // Prepare output filename
-    std::string inputFile = argv[1];
-    std::string outFile;
-    if (inputFile.size() >= 4 && inputFile.substr(inputFile.size() - 4) == ".asm") {
+    if (!outFile.empty()) {
+        // given with -o
+    } else if (inputFile == "-") {
+        outFile = "a.vm";
+    } else if (inputFile.size() >= 4 && inputFile.substr(inputFile.size() - 4) == ".asm") {
         outFile = inputFile.substr(0, inputFile.size() - 4) + ".vm";
     } else {
         outFile = inputFile + ".vm";
     }
 
     // Write VM binary file using SymbolTable directly
-    assembler::writeVMFile(outFile, final_bytes, symtab);
+    {
+        assembler::stats::Phase phase("write");
+        if (!assembler::writeVMFile(outFile, pool_bytes, enc.code, symtab, strings))
+            return 4;
+    }
+
+    // Reads the file back through the reference loader
+    if (verify) {
+        assembler::stats::Phase phase("verify");
+        assembler::VMImage image;
+        std::string err;
+        if (!image.open(outFile, err) || !image.verify(err)) {
+            std::cerr << "Error: " << outFile << ": " << err << "\n";
+            return 4;
+        }
+        LOG_INFO("verified " << outFile);
+    }
 
-    std::cout << "\nWrote binary file: " << outFile << "\n";
+    out.flush();
+    LOG_INFO("wrote binary file: " << outFile);
+
+    if (stats) {
+        if (statsFile.empty()) {
+            assembler::stats::write_json(std::cerr);
+        } else {
+            std::ofstream js(statsFile);
+            assembler::stats::write_json(js);
+        }
+    }
 
     return 0;
 }
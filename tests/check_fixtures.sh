@@ -0,0 +1,49 @@
+#!/bin/sh
+# ============================================================================
+# check_fixtures.sh - run each tests/opt_*.asm and diff it against its header
+#
+#   tests/check_fixtures.sh [assembler]     (default: bin/assembler)
+#
+# A fixture starts with a comment block:
+#
+#   ; Expected from `assembler <options> tests/<name>.asm`:
+#   ;   <dump line, without its index and source line>
+#
+# The assembler is run with those options from the repository root. Its dump
+# must match the block line for line, and it must exit 0 with nothing on
+# stderr.
+# ============================================================================
+ASM=${1:-bin/assembler}
+cd "$(dirname "$0")/.." || exit 2
+[ -x "$ASM" ] || { echo "check_fixtures: no assembler at $ASM" >&2; exit 2; }
+
+TMP=${TMPDIR:-/tmp}/check_fixtures.$$
+mkdir -p "$TMP" || exit 2
+trap 'rm -rf "$TMP"' EXIT
+
+failed=0
+for f in tests/opt_*.asm; do
+    args=$(sed -n 's/^; Expected from `assembler \(.*\)`:$/\1/p' "$f")
+    if [ -z "$args" ]; then
+        echo "FAIL $f: no expected block"
+        failed=1
+        continue
+    fi
+    sed -n 's/^;   //p' "$f" > "$TMP/expected"
+    # shellcheck disable=SC2086
+    "$ASM" $args -o "$TMP/out.vm" > "$TMP/stdout" 2> "$TMP/stderr"
+    rc=$?
+    grep -v '^===\|^$' "$TMP/stdout" |
+        sed -e 's/^[0-9]*: //' -e 's/ *(src line [0-9]*)$//' > "$TMP/actual"
+    if [ $rc -ne 0 ] || [ -s "$TMP/stderr" ]; then
+        echo "FAIL $f: exit $rc"
+        cat "$TMP/stderr"
+        failed=1
+    elif ! diff -u "$TMP/expected" "$TMP/actual"; then
+        echo "FAIL $f"
+        failed=1
+    else
+        echo "ok   $f"
+    fi
+done
+exit $failed
@@ -0,0 +1,39 @@
+; Jump threading and unreachable code (-O). The chain L0 -> L1 -> L4 ->
+; L5 -> L0 loops back on itself: threading must stop rather than spin, and
+; leaves every jump still inside the loop. L4 and L5 are then unreachable
+; and dropped with the PUSH/POP after RET.
+;
+; Expected from `assembler -O --dump=instrs tests/opt_cfg.asm`:
+;   LOAD #0
+;   JZ_S L1
+;   LOAD #0
+;   JNZ_S L3
+;   LOAD #0
+;   RET
+;   JMP_S L0
+;   JMP_S L0
+;   JMP_S L3
+
+.method main
+.limit stack 1
+.limit locals 1
+    LOAD 0
+    JZ L0           ; enters the loop L0 -> L1 -> L4 -> L5 -> L0
+    LOAD 0
+    JNZ L3
+    LOAD 0
+    RET
+    PUSH 1          ; unreachable
+    POP
+L0:
+    JMP L1
+L1:
+L2:                 ; merged into L1
+    JMP L4
+L3:
+    JMP L3          ; jumps to itself
+L4:
+    JMP L5
+L5:
+    JMP L0
+.end
@@ -0,0 +1,71 @@
+; Constant folding (-O). Folds arithmetic on literals, identities and
+; branches on a constant, but keeps a division that traps at run time,
+; float arithmetic and a pair of operands split by a label.
+;
+; Expected from `assembler -O --dump=instrs tests/opt_fold.asm`:
+;   PUSH #-40
+;   STORE #0
+;   LOAD #0
+;   STORE #0
+;   PUSH #1
+;   PUSH #0
+;   IDIV
+;   POP
+;   PUSH #-2147483648
+;   PUSH #-1
+;   IDIV
+;   POP
+;   FPUSH #-1
+;   FPUSH #1065353216
+;   FADD
+;   FPOP
+;   PUSH #2
+;   PUSH #3
+;   IADD
+;   DUP
+;   JNZ_S L0
+;   POP
+;   LOAD #0
+;   RET
+
+.method main
+.limit stack 2
+.limit locals 1
+    PUSH 6          ; -(6 * 7 - 2)  ->  PUSH -40
+    PUSH 7
+    IMUL
+    PUSH 2
+    ISUB
+    INEG
+    STORE 0
+    LOAD 0          ; x + 0, x * 1: both dropped
+    PUSH 0
+    IADD
+    PUSH 1
+    IMUL
+    STORE 0
+    PUSH 1          ; division by zero traps at run time: kept
+    PUSH 0
+    IDIV
+    POP
+    PUSH -2147483648 ; INT_MIN / -1 traps too: kept
+    PUSH -1
+    IDIV
+    POP
+    FPUSH -1        ; float operands are raw bits (-1 is a NaN); never folded
+    FPUSH 1065353216
+    FADD
+    FPOP
+    PUSH 2
+L0:                 ; the operands straddle a label: not folded
+    PUSH 3
+    IADD
+    DUP
+    JNZ L0          ; back to L0 with the sum on the stack, as on entry
+    POP
+    PUSH 0          ; never taken: PUSH and JNZ dropped
+    JNZ L1
+L1:
+    LOAD 0
+    RET
+.end
@@ -0,0 +1,68 @@
+; Superinstructions (--fuse=all). IINC takes a one-byte slot and a
+; signed one-byte delta, so an increment by 200 stays LOAD/PUSH/IADD/STORE.
+;
+; Expected from `assembler --fuse=all --dump=instrs tests/opt_fuse.asm`:
+;   PUSH #0
+;   STORE #0
+;   PUSH #0
+;   STORE #1
+;   IINC #0 #1
+;   LOAD #1
+;   IINC #1 #-2
+;   POP
+;   LOAD #1
+;   PUSH #200
+;   IADD
+;   STORE #1
+;   IINC #1 #-128
+;   LOAD #0
+;   PUSH #10
+;   IF_ICMPLT L0
+;   LOAD #0
+;   PUSH #3
+;   IF_ICMPNEQ L1
+;   LOAD #1
+;   RET
+;   LOAD #0
+;   RET
+
+.method main
+.limit stack 3
+.limit locals 2
+    PUSH 0
+    STORE 0
+    PUSH 0
+    STORE 1
+L0:
+    LOAD 0          ; i += 1  ->  IINC 0,1
+    PUSH 1
+    IADD
+    STORE 0
+    LOAD 1          ; j-- with the old value kept  ->  LOAD 1; IINC 1,-2
+    DUP
+    PUSH 2
+    ISUB
+    STORE 1
+    POP
+    LOAD 1          ; 200 does not fit IINC's int8 delta: not fused
+    PUSH 200
+    IADD
+    STORE 1
+    LOAD 1          ; -128 does
+    PUSH -128
+    IADD
+    STORE 1
+    LOAD 0
+    PUSH 10
+    ICMP_LT         ; ICMP_LT; JNZ  ->  IF_ICMPLT
+    JNZ L0
+    LOAD 0
+    PUSH 3
+    ICMP_EQ         ; ICMP_EQ; JZ  ->  IF_ICMPNEQ
+    JZ L1
+    LOAD 1
+    RET
+L1:
+    LOAD 0
+    RET
+.end
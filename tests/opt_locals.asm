@@ -0,0 +1,91 @@
+; Local slot coalescing (-O). Slots whose live ranges do not overlap
+; share a number, and each method's declared .limit locals shrinks by the
+; slots saved: main 4 -> 2, count 3 -> 2.
+;
+; Expected from `assembler -O --dump=instrs,symtab tests/opt_locals.asm`:
+;   PUSH #1
+;   STORE #1
+;   LOAD #1
+;   PUSH #2
+;   IMUL
+;   STORE #1
+;   LOAD #1
+;   PUSH #3
+;   IADD
+;   STORE #1
+;   LOAD #0
+;   LOAD #1
+;   IADD
+;   RET
+;   PUSH #0
+;   STORE #0
+;   PUSH #0
+;   STORE #1
+;   LOAD #1
+;   LOAD #0
+;   IADD
+;   STORE #1
+;   LOAD #0
+;   PUSH #1
+;   IADD
+;   STORE #0
+;   LOAD #0
+;   PUSH #5
+;   ICMP_LT
+;   JNZ_S L0
+;   LOAD #1
+;   PUSH #2
+;   IMUL
+;   STORE #0
+;   LOAD #0
+;   RET
+;   Label L0 -> addr=74 (defined at line 72, col 1)
+;   Method count addr=54 stack=2 locals=2
+;   Method main addr=0 stack=2 locals=2
+
+.method main
+.limit stack 2
+.limit locals 4
+    PUSH 1
+    STORE 1         ; slots 1, 2 and 3 are never live together: all become 1
+    LOAD 1
+    PUSH 2
+    IMUL
+    STORE 2         ; slot 1 died at the LOAD above: slot 2 becomes 1
+    LOAD 2
+    PUSH 3
+    IADD
+    STORE 3
+    LOAD 0          ; slot 0 is read before any write, so it keeps its number
+    LOAD 3
+    IADD
+    RET
+.end
+
+.method count
+.limit stack 2
+.limit locals 3
+    PUSH 0
+    STORE 0
+    PUSH 0
+    STORE 1         ; the sum and the counter (slot 0) are live across the loop
+L0:
+    LOAD 1
+    LOAD 0
+    IADD
+    STORE 1
+    LOAD 0
+    PUSH 1
+    IADD
+    STORE 0
+    LOAD 0
+    PUSH 5
+    ICMP_LT
+    JNZ L0
+    LOAD 1
+    PUSH 2
+    IMUL
+    STORE 2         ; slot 2 is written after the counter dies: becomes 0
+    LOAD 2
+    RET
+.end
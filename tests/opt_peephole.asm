@@ -0,0 +1,51 @@
+; Peephole rewrites (-O). Each rule fires once; the DUP/POP pair split
+; by L2 must survive, since a jump to L2 would find one value fewer.
+; JZ L1 comes out as JZ_S after branch relaxation.
+;
+; Expected from `assembler -O --dump=instrs tests/opt_peephole.asm`:
+;   PUSH #0
+;   STORE #0
+;   LOAD #0
+;   PUSH #1
+;   IADD
+;   STORE #0
+;   LOAD #0
+;   PUSH #3
+;   ICMP_LT
+;   JZ_S L1
+;   LOAD #0
+;   DUP
+;   POP
+;   POP
+;   LOAD #0
+;   RET
+
+.method main
+.limit stack 3
+.limit locals 1
+    PUSH 0
+    STORE 0
+    LOAD 0          ; a++ with the old value dropped:
+    DUP             ; dead-dup-pop removes DUP and POP
+    PUSH 1
+    IADD
+    STORE 0
+    POP
+    LOAD 0
+    PUSH 3
+    ICMP_LT
+    JNZ L0          ; branch-over-jump: becomes JZ L1
+    JMP L1
+L0:
+    PUSH 7          ; push-pop
+    POP
+    JMP L1          ; jump-to-next
+L1:
+    LOAD 0
+    DUP
+L2:                 ; DUP; POP crosses a label: kept
+    POP
+    POP
+    LOAD 0
+    RET
+.end